@@ -0,0 +1,333 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/action.hpp>
+#include <libstream/any_stream.hpp>
+#include <libstream/connect.hpp>
+#include <libstream/demultiplex.hpp>
+#include <libstream/filter.hpp>
+#include <libstream/framing.hpp>
+#include <libstream/fused.hpp>
+#include <libstream/kernel.hpp>
+#include <libstream/take_until.hpp>
+#include <libstream/transform.hpp>
+
+#include <benchmarks/harness.hpp>
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <cstdint>
+
+using namespace stream;
+using bench::do_not_optimize;
+using bench::memory_stream;
+
+namespace
+{
+constexpr std::size_t range_size = 64;
+
+void bench_baseline(bench::runner& r)
+{
+    memory_stream               s;
+    bench::read_sink            rsink;
+    bench::write_sink           wsink;
+    const auto                  rt = rsink.token();
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    r.run("baseline/read/sync", [&] { do_not_optimize(s.read().submit()); });
+    r.run("baseline/read/async", [&] {
+        s.read().submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+    r.run("baseline/read_range/sync", [&] {
+        s.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("baseline/write/sync", [&] { s.write(1).submit(); });
+    r.run("baseline/write/async", [&] { s.write(1).submit(base_token{wt}); });
+    r.run("baseline/write_range/sync", [&] { s.write(a).submit(); });
+
+    r.run("hand_written/transform_read/sync",
+          [&] { do_not_optimize(s.read().submit() + 1); });
+    r.run("hand_written/filter_read/sync", [&] {
+        int v;
+        do
+        {
+            v = s.read().submit();
+        } while(!(v & 1));
+        do_not_optimize(v);
+    });
+    r.run("hand_written/demultiplex_write/sync", [&] {
+        s.write(1).submit();
+        s.write(1).submit();
+    });
+}
+
+void bench_action(bench::runner& r)
+{
+    memory_stream     s;
+    bench::write_sink wsink;
+    const auto        wt = wsink.token();
+    auto              as = stream::action(s, bench::noop_action{});
+
+    r.run("action/write/sync", [&] { as.write(1).submit(); });
+    r.run("action/write/async", [&] {
+        auto sender = as.write(1);
+        sender.submit(base_token{wt});
+    });
+}
+
+void bench_any_stream(bench::runner& r)
+{
+    memory_stream               s;
+    bench::read_sink            rsink;
+    bench::write_sink           wsink;
+    const auto                  rt = rsink.token();
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    any_read_stream<int> rs{
+        stream::transform_read(s, [](int v) { return v + 1; })};
+    any_write_stream<int> ws{s};
+
+    r.run("any_stream/read/sync", [&] { do_not_optimize(rs.read().submit()); });
+    r.run("any_stream/read/async", [&] {
+        auto sender = rs.read();
+        sender.submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+    r.run("any_stream/read_range/sync", [&] {
+        rs.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("any_stream/write/sync", [&] { ws.write(1).submit(); });
+    r.run("any_stream/write/async", [&] {
+        auto sender = ws.write(1);
+        sender.submit(base_token{wt});
+    });
+    r.run("any_stream/write_range/sync", [&] { ws.write(a).submit(); });
+}
+
+void bench_transform(bench::runner& r)
+{
+    memory_stream               s;
+    bench::read_sink            rsink;
+    bench::write_sink           wsink;
+    const auto                  rt = rsink.token();
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    auto rs = stream::transform_read(s, [](int v) { return v + 1; });
+    auto ws = stream::transform_write(s, [](int v) { return v + 1; });
+    auto ks = stream::transform_read(s, offset_kernel<int>{1});
+
+    r.run("transform_read/read/sync",
+          [&] { do_not_optimize(rs.read().submit()); });
+    r.run("transform_read/read/async", [&] {
+        auto sender = rs.read();
+        sender.submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+    r.run("transform_read/read_range/sync", [&] {
+        rs.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("transform_read/read_range/async", [&] {
+        rs.read(a).submit(base_token{wt});
+        do_not_optimize(a);
+    });
+    r.run("transform_read/read_range/kernel", [&] {
+        ks.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("transform_write/write/sync", [&] { ws.write(1).submit(); });
+    r.run("transform_write/write/async",
+          [&] { ws.write(1).submit(base_token{wt}); });
+    r.run("transform_write/write_range/sync", [&] { ws.write(a).submit(); });
+    r.run("transform_write/write_range/async",
+          [&] { ws.write(a).submit(base_token{wt}); });
+}
+
+void bench_filter(bench::runner& r)
+{
+    memory_stream               s;
+    bench::read_sink            rsink;
+    bench::write_sink           wsink;
+    const auto                  rt = rsink.token();
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    auto rs = stream::filter_read(s, [](int v) { return v & 1; });
+    auto ws = stream::filter_write(s, [](int v) { return v & 1; });
+    auto bs = stream::filter_read(s, not_equal_predicate<int>{0});
+
+    r.run("filter_read/read/sync",
+          [&] { do_not_optimize(rs.read().submit()); });
+    r.run("filter_read/read/async", [&] {
+        auto sender = rs.read();
+        sender.submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+    r.run("filter_read/read_range/sync", [&] {
+        rs.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("filter_read/read_range/async", [&] {
+        rs.read(a).submit(base_token{wt});
+        do_not_optimize(a);
+    });
+    r.run("filter_read/read_range/bulk", [&] {
+        bs.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("filter_write/write/sync", [&] { ws.write(1).submit(); });
+    r.run("filter_write/write/async",
+          [&] { ws.write(1).submit(base_token{wt}); });
+    r.run("filter_write/write_range/sync", [&] { ws.write(a).submit(); });
+    r.run("filter_write/write_range/async",
+          [&] { ws.write(a).submit(base_token{wt}); });
+}
+
+void bench_fused(bench::runner& r)
+{
+    memory_stream    s;
+    bench::read_sink rsink;
+    const auto       rt = rsink.token();
+
+    auto nested = stream::transform_read(
+        stream::filter_read(
+            stream::transform_read(s, [](int v) { return v + 1; }),
+            [](int v) { return v & 1; }),
+        [](int v) { return v * 2; });
+    auto fused = s | (stream::transform_read([](int v) { return v + 1; }) |
+                      stream::filter_read([](int v) { return v & 1; }) |
+                      stream::transform_read([](int v) { return v * 2; }));
+
+    r.run("nested_read/read/sync",
+          [&] { do_not_optimize(nested.read().submit()); });
+    r.run("nested_read/read/async", [&] {
+        auto sender = nested.read();
+        sender.submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+    r.run("nested_read/read/connect", [&] {
+        auto op = connect(nested.read(), rsink);
+        op.start();
+        do_not_optimize(rsink.value_);
+    });
+    r.run("fused_read/read/sync",
+          [&] { do_not_optimize(fused.read().submit()); });
+    r.run("fused_read/read/async", [&] {
+        auto sender = fused.read();
+        sender.submit(read_token<int>{rt});
+        do_not_optimize(rsink.value_);
+    });
+}
+
+void bench_take_until(bench::runner& r)
+{
+    memory_stream               s;
+    bench::write_sink           wsink;
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    auto rs = stream::take_until_read(s, [](int v) { return v < 0; });
+    auto bs =
+        stream::take_until_bulk_read(s, terminator<int>{-1}, 2 * range_size);
+
+    r.run("take_until_read/read_range/sync", [&] {
+        rs.read(a).submit();
+        do_not_optimize(a);
+    });
+    r.run("take_until_read/read_range/async", [&] {
+        rs.read(a).submit(base_token{wt});
+        do_not_optimize(a);
+    });
+    r.run("take_until_bulk_read/read_range/sync", [&] {
+        auto sender = bs.read(a);
+        sender.submit();
+        do_not_optimize(sender.size());
+    });
+    r.run("take_until_bulk_read/read_range/async", [&] {
+        auto sender = bs.read(a);
+        sender.submit(base_token{wt});
+        do_not_optimize(sender.size());
+    });
+}
+
+void bench_framing(bench::runner& r)
+{
+    memory_stream                        s;
+    std::array<std::uint8_t, range_size> a{};
+    std::array<int, 256>                 frame{};
+    for(std::size_t i = 0; i < a.size(); ++i)
+    {
+        a[i] = static_cast<std::uint8_t>(i * 7);
+    }
+
+    auto cs =
+        stream::cobs_encode_write<std::uint8_t, cobs_encoded_size(range_size)>(
+            s);
+    auto ss =
+        stream::slip_encode_write<std::uint8_t, slip_encoded_size(range_size)>(
+            s);
+    auto ds = stream::slip_decode_read(s);
+
+    r.run("cobs_encode_write/write_range/sync",
+          [&] { cs.write(a).submit(); });
+    r.run("slip_encode_write/write_range/sync",
+          [&] { ss.write(a).submit(); });
+    // The counter of the memory stream contains an END every 256 values.
+    r.run("slip_decode_read/read_range/sync", [&] {
+        auto sender = ds.read(frame);
+        sender.submit();
+        do_not_optimize(sender.size());
+    });
+}
+
+void bench_demultiplex(bench::runner& r)
+{
+    memory_stream               s1, s2;
+    bench::write_sink           wsink;
+    const auto                  wt = wsink.token();
+    std::array<int, range_size> a{};
+
+    auto ds = stream::demultiplex(s1, s2);
+    auto cs = stream::demultiplex(stream::concurrent, s1, s2);
+
+    r.run("demultiplex/write/sync", [&] { ds.write(1).submit(); });
+    r.run("demultiplex/write/async", [&] {
+        auto sender = ds.write(1);
+        sender.submit(base_token{wt});
+    });
+    r.run("demultiplex/write_range/sync", [&] { ds.write(a).submit(); });
+    r.run("demultiplex/write_range/async", [&] {
+        auto sender = ds.write(a);
+        sender.submit(base_token{wt});
+    });
+    r.run("demultiplex_concurrent/write/async", [&] {
+        auto sender = cs.write(1);
+        sender.submit(base_token{wt});
+    });
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench::runner r{argc, argv};
+
+    bench_baseline(r);
+    bench_action(r);
+    bench_any_stream(r);
+    bench_transform(r);
+    bench_filter(r);
+    bench_fused(r);
+    bench_take_until(r);
+    bench_framing(r);
+    bench_demultiplex(r);
+}
@@ -0,0 +1,101 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef BENCHMARKS_HARNESS_HPP_
+#define BENCHMARKS_HARNESS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace bench
+{
+template<class T> inline void do_not_optimize(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+class runner
+{
+    std::size_t iterations_  = 1000000;
+    std::size_t repetitions_ = 5;
+    const char* filter_      = nullptr;
+
+    /*!
+     * Parses the count of an option and exits if it is not a positive number.
+     */
+    static std::size_t parse_count(const char* option, const char* value)
+    {
+        char* end = nullptr;
+        auto  n   = std::strtoull(value, &end, 10);
+        if(n == 0 || end == value || *end != '\0')
+        {
+            std::fprintf(stderr, "%s expects a positive number, got '%s'.\n",
+                         option, value);
+            std::exit(EXIT_FAILURE);
+        }
+        return n;
+    }
+
+  public:
+    runner(int argc, char** argv)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            if(std::strncmp(argv[i], "--iterations=", 13) == 0)
+            { iterations_ = parse_count("--iterations", argv[i] + 13); }
+            else if(std::strncmp(argv[i], "--repetitions=", 14) == 0)
+            {
+                repetitions_ = parse_count("--repetitions", argv[i] + 14);
+            }
+            else
+            {
+                filter_ = argv[i];
+            }
+        }
+        std::printf("%-48s %12s %16s\n", "benchmark", "ns/op", "ops/s");
+    }
+
+    /*!
+     * Runs f iterations_ times per repetition and reports the fastest
+     * repetition, which is the least disturbed by the rest of the system.
+     */
+    template<class F> void run(const char* name, F&& f)
+    {
+        if(filter_ && !std::strstr(name, filter_)) { return; }
+
+        using clock = std::chrono::steady_clock;
+        for(std::size_t i = 0; i < iterations_ / 10; ++i) { f(); }
+
+        double best = 0;
+        for(std::size_t r = 0; r < repetitions_; ++r)
+        {
+            auto start = clock::now();
+            for(std::size_t i = 0; i < iterations_; ++i)
+            {
+                f();
+                clobber_memory();
+            }
+            std::chrono::duration<double, std::nano> elapsed =
+                clock::now() - start;
+            double ns = elapsed.count() / iterations_;
+            best      = r == 0 ? ns : std::min(best, ns);
+        }
+
+        std::printf("%-48s %12.2f %16.0f\n", name, best, 1e9 / best);
+    }
+};
+
+} // namespace bench
+
+#endif // BENCHMARKS_HARNESS_HPP_
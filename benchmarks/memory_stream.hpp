@@ -0,0 +1,127 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef BENCHMARKS_MEMORY_STREAM_HPP_
+#define BENCHMARKS_MEMORY_STREAM_HPP_
+
+#include <libstream/callback.hpp>
+
+#include <experimental/ranges/range>
+
+namespace bench
+{
+/*!
+ * In-memory stream which completes every operation inline.
+ *
+ * Reads produce an incrementing counter, writes accumulate into a sink, so
+ * the measured time is dominated by the adaptors layered on top.
+ */
+struct memory_stream
+{
+    mutable int counter_ = 0;
+    mutable int sink_    = 0;
+
+    struct sender
+    {
+        const memory_stream& stream_;
+
+        int  submit() { return stream_.counter_++; }
+        void submit(stream::read_token<int>&& t) { t.done(stream_.counter_++); }
+        void cancel() {}
+    };
+
+    struct write_sender
+    {
+        const memory_stream& stream_;
+        int                  value_;
+
+        void submit() { stream_.sink_ += value_; }
+        void submit(stream::base_token&& t)
+        {
+            stream_.sink_ += value_;
+            t.done();
+        }
+        void cancel() {}
+    };
+
+    struct range_sender
+    {
+        void submit() {}
+        void submit(stream::base_token&& t) { t.done(); }
+        void cancel() {}
+    };
+
+    sender read() const { return sender{*this}; }
+
+    template<std::experimental::ranges::Range R>
+    range_sender read(R&& r) const
+    {
+        for(auto&& v : r) { v = counter_++; }
+        return range_sender{};
+    }
+
+    write_sender write(int v) const { return write_sender{*this, v}; }
+
+    template<std::experimental::ranges::InputRange R>
+    range_sender write(R&& r) const
+    {
+        for(auto&& v : r) { sink_ += v; }
+        return range_sender{};
+    }
+};
+
+struct noop_action
+{
+    struct sender
+    {
+        void submit() {}
+        void submit(stream::base_token t) { t.done(); }
+        void cancel() {}
+    };
+
+    sender operator()() const { return sender{}; }
+};
+
+struct read_sink
+{
+    int value_ = 0;
+
+    void done(int v) { value_ = v; }
+    void error(stream::error_code) {}
+    void cancelled() {}
+
+    stream::read_token<int> token()
+    {
+        return {stream::error_token::create<read_sink, &read_sink::error>(this),
+                stream::cancel_token::create<read_sink, &read_sink::cancelled>(
+                    this),
+                stream::read_done_token<int>::create<read_sink,
+                                                     &read_sink::done>(this)};
+    }
+};
+
+struct write_sink
+{
+    int count_ = 0;
+
+    void done() { ++count_; }
+    void error(stream::error_code) {}
+    void cancelled() {}
+
+    stream::base_token token()
+    {
+        return {
+            stream::error_token::create<write_sink, &write_sink::error>(this),
+            stream::cancel_token::create<write_sink, &write_sink::cancelled>(
+                this),
+            stream::done_token::create<write_sink, &write_sink::done>(this)};
+    }
+};
+
+} // namespace bench
+
+#endif // BENCHMARKS_MEMORY_STREAM_HPP_
@@ -0,0 +1,39 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/action.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+int read_sync(const memory_stream& s)
+{
+    return action(s, bench::noop_action{}).read().submit();
+}
+
+void read_async(const memory_stream& s, read_token<int> t)
+{
+    auto sender = action(s, bench::noop_action{}).read();
+    sender.submit(std::move(t));
+}
+
+void read_range(const memory_stream& s, std::array<int, 64>& a, base_token t)
+{
+    auto sender = action(s, bench::noop_action{}).read(a);
+    sender.submit(std::move(t));
+}
+
+void write_async(const memory_stream& s, int v, base_token t)
+{
+    auto sender = action(s, bench::noop_action{}).write(v);
+    sender.submit(std::move(t));
+}
@@ -0,0 +1,29 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/any_stream.hpp>
+#include <libstream/transform.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+any_read_stream<int> make_stream(const memory_stream& s)
+{
+    return any_read_stream<int>{transform_read(s, [](int x) { return x + 1; })};
+}
+
+int read_sync(const any_read_stream<int>& s) { return s.read().submit(); }
+
+void read_async(const any_read_stream<int>& s, read_token<int> t)
+{
+    auto sender = s.read();
+    sender.submit(std::move(t));
+}
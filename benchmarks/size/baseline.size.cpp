@@ -0,0 +1,31 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+int read_sync(const memory_stream& s) { return s.read().submit(); }
+
+void read_async(const memory_stream& s, read_token<int> t)
+{
+    s.read().submit(std::move(t));
+}
+
+void read_range(const memory_stream& s, std::array<int, 64>& a, base_token t)
+{
+    s.read(a).submit(std::move(t));
+}
+
+void write_async(const memory_stream& s, int v, base_token t)
+{
+    s.write(v).submit(std::move(t));
+}
@@ -0,0 +1,32 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/buffered.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+void write_async(const memory_stream& s, const std::array<int, 64>& a,
+                 base_token t)
+{
+    auto buffered = buffered_write<int>(s, 256);
+    auto sender   = buffered.write(a);
+    sender.submit(std::move(t));
+    buffered.flush().submit();
+}
+
+void read_async(const memory_stream& s, read_token<int> t)
+{
+    auto buffered = buffered_read<int>(s, 256);
+    auto sender   = buffered.read();
+    sender.submit(std::move(t));
+}
@@ -0,0 +1,37 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/demultiplex.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+void write_async(const memory_stream& s1, const memory_stream& s2, int v,
+                 base_token t)
+{
+    auto sender = demultiplex(s1, s2).write(v);
+    sender.submit(std::move(t));
+}
+
+void write_range(const memory_stream& s1, const memory_stream& s2,
+                 std::array<int, 64>& a, base_token t)
+{
+    auto sender = demultiplex(s1, s2).write(a);
+    sender.submit(std::move(t));
+}
+
+void write_concurrent(const memory_stream& s1, const memory_stream& s2, int v,
+                      base_token t)
+{
+    auto sender = demultiplex(concurrent, s1, s2).write(v);
+    sender.submit(std::move(t));
+}
@@ -0,0 +1,47 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/filter.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+int read_sync(const memory_stream& s)
+{
+    auto fs = filter_read(s, [](int x) { return x & 1; });
+    return fs.read().submit();
+}
+
+void read_async(const memory_stream& s, read_token<int> t)
+{
+    auto fs = filter_read(s, [](int x) { return x & 1; });
+    fs.read().submit(std::move(t));
+}
+
+void read_range(const memory_stream& s, std::array<int, 64>& a, base_token t)
+{
+    auto fs = filter_read(s, [](int x) { return x & 1; });
+    fs.read(a).submit(std::move(t));
+}
+
+void write_async(const memory_stream& s, int v, base_token t)
+{
+    auto fs = filter_write(s, [](int x) { return x & 1; });
+    fs.write(v).submit(std::move(t));
+}
+
+void write_range(const memory_stream& s, const std::array<int, 64>& a,
+                 base_token t)
+{
+    auto fs = filter_write(s, [](int x) { return x & 1; });
+    fs.write(a).submit(std::move(t));
+}
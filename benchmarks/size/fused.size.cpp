@@ -0,0 +1,34 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/filter.hpp>
+#include <libstream/fused.hpp>
+#include <libstream/transform.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+namespace
+{
+auto fused(const memory_stream& s)
+{
+    return s | (transform_read([](int v) { return v + 1; }) |
+                filter_read([](int v) { return v & 1; }) |
+                transform_read([](int v) { return v * 2; }));
+}
+} // namespace
+
+int read_sync(const memory_stream& s) { return fused(s).read().submit(); }
+
+void read_async(const memory_stream& s, read_token<int> t)
+{
+    fused(s).read().submit(std::move(t));
+}
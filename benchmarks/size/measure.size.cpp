@@ -0,0 +1,27 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/measure.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+int read_sync(const memory_stream& s, histogram& h)
+{
+    return measure(s, h).read().submit();
+}
+
+void read_async(const memory_stream& s, histogram& h, read_token<int> t)
+{
+    auto sender = measure(s, h).read();
+    sender.submit(std::move(t));
+}
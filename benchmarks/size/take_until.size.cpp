@@ -0,0 +1,22 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/take_until.hpp>
+
+#include <benchmarks/memory_stream.hpp>
+
+#include <array>
+#include <utility>
+
+using namespace stream;
+using bench::memory_stream;
+
+void read_range(const memory_stream& s, std::array<int, 64>& a, base_token t)
+{
+    auto ts = take_until_read(s, [](int x) { return x < 0; });
+    ts.read(a).submit(std::move(t));
+}
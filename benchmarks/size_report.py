@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""Compile time and code size report of the pipelines in benchmarks/size.
+
+    size_report.py time <compiler command...>
+        Runs the compiler command and stores its CPU time next to the object
+        file. Used as RULE_LAUNCH_COMPILE of the stream_size_pipelines target.
+
+    size_report.py report [options] <object directory>
+        Prints compile time, section sizes and the largest code symbols of
+        every object below the directory. --json stores the results,
+        --compare fails if they grew beyond the tolerance of a stored run.
+"""
+
+import argparse
+import json
+import os
+import resource
+import struct
+import subprocess
+import sys
+
+SUFFIXES = (".size.cpp.o", ".size.cpp.obj")
+
+
+def time_compile(command):
+    before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    result = subprocess.call(command)
+    after = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+    if result == 0 and "-o" in command:
+        output = command[command.index("-o") + 1]
+        seconds = (after.ru_utime - before.ru_utime) + (
+            after.ru_stime - before.ru_stime)
+        with open(output + ".time", "w") as f:
+            json.dump({"cpu_seconds": seconds}, f)
+    return result
+
+
+def elf_sections(path):
+    """Sizes of the allocated sections of an ELF object by kind."""
+    sizes = {"text": 0, "rodata": 0, "data": 0, "bss": 0}
+    with open(path, "rb") as f:
+        image = f.read()
+    if image[:4] != b"\x7fELF":
+        return None
+
+    endian = "<" if image[5] == 1 else ">"
+    if image[4] == 2:
+        shoff, = struct.unpack_from(endian + "Q", image, 0x28)
+        shentsize, shnum = struct.unpack_from(endian + "HH", image, 0x3A)
+        header = endian + "IIQQQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", image, 0x20)
+        shentsize, shnum = struct.unpack_from(endian + "HH", image, 0x2E)
+        header = endian + "IIIIII"
+
+    for i in range(shnum):
+        _, kind, flags, _, _, size = struct.unpack_from(
+            header, image, shoff + i * shentsize)
+        if not flags & 0x2:
+            continue
+        if flags & 0x4:
+            sizes["text"] += size
+        elif kind == 8:
+            sizes["bss"] += size
+        elif flags & 0x1:
+            sizes["data"] += size
+        else:
+            sizes["rodata"] += size
+    return sizes
+
+
+def code_symbols(nm, path):
+    output = subprocess.check_output(
+        [nm, "-C", "-S", "--size-sort", "--defined-only", path],
+        universal_newlines=True)
+    symbols = []
+    for line in output.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "tTwW":
+            symbols.append((int(fields[1], 16), fields[3]))
+    return sorted(symbols, reverse=True)
+
+
+def find_objects(directory):
+    for root, _, files in os.walk(directory):
+        for name in files:
+            if name.endswith(SUFFIXES):
+                pipeline = name[:name.index(".size.cpp")]
+                yield pipeline, os.path.join(root, name)
+
+
+def measure(nm, directory):
+    results = {}
+    for pipeline, path in sorted(find_objects(directory)):
+        result = {"object": os.path.getsize(path)}
+        result.update(elf_sections(path) or {})
+        try:
+            with open(path + ".time") as f:
+                result.update(json.load(f))
+        except IOError:
+            pass
+        result["symbols"] = code_symbols(nm, path)
+        results[pipeline] = result
+    return results
+
+
+def print_report(results, symbols):
+    print("%-16s %10s %10s %10s %10s %10s %12s" %
+          ("pipeline", "compile s", "text", "rodata", "data", "bss",
+           "object"))
+    for pipeline, r in results.items():
+        print("%-16s %10.2f %10d %10d %10d %10d %12d" %
+              (pipeline, r.get("cpu_seconds", 0), r.get("text", 0),
+               r.get("rodata", 0), r.get("data", 0), r.get("bss", 0),
+               r["object"]))
+
+    for pipeline, r in results.items():
+        print("\n%s: largest of %d code symbols" %
+              (pipeline, len(r["symbols"])))
+        for size, name in r["symbols"][:symbols]:
+            print("%10d  %s" % (size, name))
+
+
+def compare(results, baseline, tolerance, time_tolerance):
+    regressions = []
+    limits = [("text", tolerance), ("rodata", tolerance), ("data", tolerance),
+              ("cpu_seconds", time_tolerance)]
+    for pipeline, r in results.items():
+        old = baseline.get(pipeline)
+        if old is None:
+            continue
+        for key, limit in limits:
+            if key in r and key in old and \
+                    r[key] > old[key] * (1 + limit / 100.0):
+                regressions.append("%s %s: %s -> %s" %
+                                   (pipeline, key, old[key], r[key]))
+    return regressions
+
+
+def main():
+    if len(sys.argv) > 1 and sys.argv[1] == "time":
+        return time_compile(sys.argv[2:])
+
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("command", choices=["report"])
+    parser.add_argument("directory")
+    parser.add_argument("--nm", default="nm")
+    parser.add_argument("--symbols", type=int, default=10,
+                        help="code symbols listed per pipeline")
+    parser.add_argument("--json", help="store the results in this file")
+    parser.add_argument("--compare", help="results of a previous run")
+    parser.add_argument("--tolerance", type=float, default=1.0,
+                        help="allowed growth of section sizes in percent")
+    parser.add_argument("--time-tolerance", type=float, default=25.0,
+                        help="allowed growth of compile time in percent")
+    args = parser.parse_args()
+
+    results = measure(args.nm, args.directory)
+    print_report(results, args.symbols)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
+
+    if args.compare:
+        with open(args.compare) as f:
+            regressions = compare(results, json.load(f), args.tolerance,
+                                  args.time_tolerance)
+        if regressions:
+            print("\nGrown beyond the tolerance:")
+            for r in regressions:
+                print("  " + r)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,6 +11,8 @@
 #include <libstream/callback.hpp>
 #include <libstream/concepts/executor.hpp>
 #include <libstream/concepts/pipe.hpp>
+#include <libstream/connect.hpp>
+#include <libstream/trace.hpp>
 
 #include <experimental/ranges/range>
 
@@ -18,6 +20,54 @@ namespace stream
 {
 namespace detail
 {
+/*!
+ * An action context connected to a receiver. The child is connected directly
+ * to the receiver, only the completion of the action passes this operation.
+ */
+template<class Pre, class Child, class R> class action_operation
+{
+    struct pre_receiver
+    {
+        action_operation* op_;
+
+        void done()
+        {
+            op_->child_submitted_ = true;
+            op_->child_.start();
+        }
+        void error(error_code e) { op_->receiver_.error(e); }
+        void cancelled() { op_->receiver_.cancelled(); }
+    };
+
+    R                                   receiver_;
+    bool                                child_submitted_ = false;
+    connect_result_t<Pre, pre_receiver> pre_;
+    connect_result_t<Child, R&>         child_;
+
+  public:
+    action_operation(Pre&& p, Child&& c, R&& r)
+        : receiver_(std::forward<R>(r)),
+          pre_(stream::connect(std::forward<Pre>(p), pre_receiver{this})),
+          child_(stream::connect(std::forward<Child>(c), receiver_))
+    {
+    }
+
+    void start()
+    {
+        child_submitted_ = false;
+        pre_.start();
+    }
+
+    void cancel()
+    {
+        if(child_submitted_) { child_.cancel(); }
+        else
+        {
+            pre_.cancel();
+        }
+    }
+};
+
 template<class Token, class Pre, class Child, class Stream> struct context
 {
     Pre           pre_;
@@ -25,6 +75,7 @@ template<class Token, class Pre, class Child, class Stream> struct context
     const Stream& stream_;
     Token         token_;
     bool          child_submitted_;
+    LIBSTREAM_TRACE_TOKEN(Token)
 
     context(Pre&& p, Child&& c, const Stream& s)
         : pre_(std::forward<Pre>(p)), child_(std::forward<Child>(c)), stream_(s)
@@ -39,17 +90,18 @@ template<class Token, class Pre, class Child, class Stream> struct context
 
     template<class T> void submit(T&& t)
     {
-        token_           = t;
+        token_           = LIBSTREAM_TRACE_WRAP("action", Token{t});
         child_submitted_ = false;
 
         using this_t = context<Token, Pre, Child, Stream>;
         pre_.submit(token<>{
-            t.error, t.cancelled,
+            token_.error, token_.cancelled,
             done_token::template create<this_t, &this_t::pre_handler>(this)});
     }
 
     auto submit()
     {
+        LIBSTREAM_TRACE_SYNC("action")
         pre_.submit();
         return child_.submit();
     }
@@ -62,6 +114,13 @@ template<class Token, class Pre, class Child, class Stream> struct context
             pre_.cancel();
         }
     }
+
+    template<class R> auto connect(R&& r) &&
+    {
+        return action_operation<Pre, Child, R>{
+            std::forward<Pre>(pre_), std::forward<Child>(child_),
+            std::forward<R>(r)};
+    }
 };
 
 template<class T, class P, class C, class S>
@@ -110,6 +169,13 @@ template<Streamable S, class Pre> requires Executable<Pre, void> class action_fn
             pre_(), stream_.write(std::forward<V>(v)), *this);
     }
 
+    template<std::experimental::ranges::ForwardRange R>
+    auto writev(R&& segments) const requires VectoredWriteStreamable<S, R>
+    {
+        return detail::make_context<base_token>(
+            pre_(), stream_.writev(std::forward<R>(segments)), *this);
+    }
+
     template<class V>
     auto readwrite(V&& v) const requires ReadWriteStreamable<S>
     {
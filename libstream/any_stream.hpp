@@ -0,0 +1,327 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_ANY_STREAM_HPP_
+#define LIBSTREAM_ANY_STREAM_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/span.hpp>
+
+#include <experimental/ranges/range>
+
+#include <cstddef>
+#include <new>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Storage of a type erased object. Objects passed as lvalue reference are
+ * referenced, all others are moved into the storage.
+ */
+template<class X>
+using erased_t =
+    std::conditional_t<std::is_lvalue_reference_v<X>,
+                       std::remove_reference_t<X>*,
+                       std::remove_cv_t<std::remove_reference_t<X>>>;
+
+template<class X> X& deref(X* x) { return *x; }
+template<class X> X& deref(X& x) { return x; }
+
+template<class X, std::size_t Size> void check_erased_size()
+{
+    static_assert(sizeof(X) <= Size,
+                  "The object does not fit into the inline storage, increase "
+                  "its Size.");
+    static_assert(alignof(X) <= alignof(std::aligned_storage_t<Size>),
+                  "The object is overaligned for the inline storage.");
+}
+
+template<class T> struct sender_vtable
+{
+    using token_type = typename token_for<T>::type;
+
+    T (*submit_)(void*);
+    void (*submit_async_)(void*, token_type&&);
+    void (*cancel_)(void*);
+    void (*move_)(void*, void*);
+    void (*destroy_)(void*);
+};
+
+template<class T, class X>
+inline constexpr sender_vtable<T> sender_vtable_for{
+    [](void* s) -> T {
+        return deref(*static_cast<X*>(s)).submit();
+    },
+    [](void* s, typename token_for<T>::type&& t) {
+        deref(*static_cast<X*>(s)).submit(std::move(t));
+    },
+    [](void* s) { deref(*static_cast<X*>(s)).cancel(); },
+    [](void* from, void* to) {
+        new(to) X{std::move(*static_cast<X*>(from))};
+    },
+    [](void* s) { static_cast<X*>(s)->~X(); }};
+
+/*!
+ * Inline storage of a type erased object with a vtable of type V.
+ */
+template<class V, std::size_t Size> class erased_storage
+{
+  protected:
+    const V*                     vtable_ = nullptr;
+    std::aligned_storage_t<Size> storage_;
+
+    template<class S> void emplace(S&& s)
+    {
+        using stored_t = erased_t<S>;
+        check_erased_size<stored_t, Size>();
+
+        if constexpr(std::is_lvalue_reference_v<S>)
+        {
+            new(&storage_) stored_t{&s};
+        }
+        else
+        {
+            new(&storage_) stored_t{std::move(s)};
+        }
+    }
+
+    void reset()
+    {
+        if(vtable_ != nullptr) { vtable_->destroy_(&storage_); }
+        vtable_ = nullptr;
+    }
+
+    erased_storage() = default;
+
+    erased_storage(erased_storage&& other) : vtable_(other.vtable_)
+    {
+        if(vtable_ != nullptr) { vtable_->move_(&other.storage_, &storage_); }
+    }
+
+    erased_storage& operator=(erased_storage&& other)
+    {
+        if(this != &other)
+        {
+            reset();
+            vtable_ = other.vtable_;
+            if(vtable_ != nullptr)
+            {
+                vtable_->move_(&other.storage_, &storage_);
+            }
+        }
+        return *this;
+    }
+
+    ~erased_storage() { reset(); }
+};
+} // namespace detail
+
+/*!
+ * Type erased sender completing with a value of type T, or without a value if
+ * T is void.
+ *
+ * The sender is stored inline in Size bytes, a sender which does not fit is
+ * rejected at compile time instead of being allocated. Every operation is a
+ * single indirect call. As all senders, an any_sender must not be moved while
+ * its operation is in flight.
+ */
+template<class T = void, std::size_t Size = 128>
+class any_sender : detail::erased_storage<detail::sender_vtable<T>, Size>
+{
+    using base_t = detail::erased_storage<detail::sender_vtable<T>, Size>;
+    using base_t::storage_;
+    using base_t::vtable_;
+
+  public:
+    using token_type = typename detail::token_for<T>::type;
+
+    template<class S>
+    requires !std::is_same_v<std::decay_t<S>, any_sender> any_sender(S&& s)
+    {
+        this->emplace(std::forward<S>(s));
+        vtable_ = &detail::sender_vtable_for<T, detail::erased_t<S>>;
+    }
+
+    T submit() { return vtable_->submit_(&storage_); }
+
+    void submit(token_type&& t)
+    {
+        vtable_->submit_async_(&storage_, std::move(t));
+    }
+
+    void cancel() { vtable_->cancel_(&storage_); }
+};
+
+namespace detail
+{
+/*!
+ * Single value read of a stream which only reads ranges, such as a frame
+ * decoder. It fails with ENOTSUP.
+ */
+template<class T> struct unsupported_read_context
+{
+    T    submit() { return T{}; }
+    void submit(read_token<T>&& t)
+    {
+        t.error(static_cast<error_code>(std::errc::operation_not_supported));
+    }
+    void cancel() {}
+};
+
+template<class S> concept bool SingleReadable = requires(S& s)
+{
+    s.read();
+};
+
+template<class T, std::size_t Size> struct read_stream_vtable
+{
+    any_sender<T, Size> (*read_)(const void*);
+    any_sender<void, Size> (*read_range_)(const void*, span<T>);
+    void (*move_)(void*, void*);
+    void (*destroy_)(void*);
+};
+
+/*
+ * Ranges are passed on as rvalue spans, so adaptors which keep the range in
+ * their sender copy the span instead of referencing the parameter.
+ */
+template<class T, std::size_t Size, class X>
+inline constexpr read_stream_vtable<T, Size> read_stream_vtable_for{
+    [](const void* s) -> any_sender<T, Size> {
+        auto& stream = deref(*const_cast<X*>(static_cast<const X*>(s)));
+        if constexpr(SingleReadable<decltype(stream)>) { return stream.read(); }
+        else
+        {
+            return unsupported_read_context<T>{};
+        }
+    },
+    [](const void* s, span<T> r) -> any_sender<void, Size> {
+        return deref(*const_cast<X*>(static_cast<const X*>(s)))
+            .read(std::move(r));
+    },
+    [](void* from, void* to) {
+        new(to) X{std::move(*static_cast<X*>(from))};
+    },
+    [](void* s) { static_cast<X*>(s)->~X(); }};
+
+template<class T, std::size_t Size> struct write_stream_vtable
+{
+    any_sender<void, Size> (*write_)(const void*, const T&);
+    any_sender<void, Size> (*write_range_)(const void*, span<const T>);
+    void (*move_)(void*, void*);
+    void (*destroy_)(void*);
+};
+
+template<class T, std::size_t Size, class X>
+inline constexpr write_stream_vtable<T, Size> write_stream_vtable_for{
+    [](const void* s, const T& v) -> any_sender<void, Size> {
+        return deref(*const_cast<X*>(static_cast<const X*>(s))).write(v);
+    },
+    [](const void* s, span<const T> r) -> any_sender<void, Size> {
+        return deref(*const_cast<X*>(static_cast<const X*>(s)))
+            .write(std::move(r));
+    },
+    [](void* from, void* to) {
+        new(to) X{std::move(*static_cast<X*>(from))};
+    },
+    [](void* s) { static_cast<X*>(s)->~X(); }};
+} // namespace detail
+
+/*!
+ * Type erased stream reading values of type T, which hides the type of an
+ * adaptor pipeline behind a fixed interface. Range reads take a span. Streams
+ * which only read ranges can be wrapped as well, their single value reads
+ * fail with ENOTSUP.
+ *
+ * A stream passed as lvalue is referenced and has to outlive the
+ * any_read_stream, all others are moved into Size bytes of inline storage.
+ * The senders it returns are stored in the same amount of inline storage.
+ */
+template<class T, std::size_t Size = 128>
+class any_read_stream
+    : detail::erased_storage<detail::read_stream_vtable<T, Size>, Size>
+{
+    using base_t =
+        detail::erased_storage<detail::read_stream_vtable<T, Size>, Size>;
+    using base_t::storage_;
+    using base_t::vtable_;
+
+  public:
+    template<PureReadStreamable S>
+    requires !std::is_same_v<std::decay_t<S>, any_read_stream>
+    any_read_stream(S&& s)
+    {
+        this->emplace(std::forward<S>(s));
+        vtable_ = &detail::read_stream_vtable_for<T, Size, detail::erased_t<S>>;
+    }
+
+    any_sender<T, Size> read() const { return vtable_->read_(&storage_); }
+
+    any_sender<void, Size> read(span<T> r) const
+    {
+        return vtable_->read_range_(&storage_, r);
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    any_sender<void, Size> read(R&& r) const
+    {
+        return read(span<T>{std::experimental::ranges::data(r),
+                            std::experimental::ranges::size(r)});
+    }
+};
+
+/*!
+ * Type erased stream writing values of type T, see any_read_stream. Range
+ * writes take a span.
+ */
+template<class T, std::size_t Size = 128>
+class any_write_stream
+    : detail::erased_storage<detail::write_stream_vtable<T, Size>, Size>
+{
+    using base_t =
+        detail::erased_storage<detail::write_stream_vtable<T, Size>, Size>;
+    using base_t::storage_;
+    using base_t::vtable_;
+
+  public:
+    template<PureWriteStreamable S>
+    requires !std::is_same_v<std::decay_t<S>, any_write_stream>
+    any_write_stream(S&& s)
+    {
+        this->emplace(std::forward<S>(s));
+        vtable_ =
+            &detail::write_stream_vtable_for<T, Size, detail::erased_t<S>>;
+    }
+
+    any_sender<void, Size> write(const T& v) const
+    {
+        return vtable_->write_(&storage_, v);
+    }
+
+    any_sender<void, Size> write(span<const T> r) const
+    {
+        return vtable_->write_range_(&storage_, r);
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    any_sender<void, Size> write(R&& r) const
+    {
+        return write(span<const T>{std::experimental::ranges::data(r),
+                                   std::experimental::ranges::size(r)});
+    }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_ANY_STREAM_HPP_
@@ -0,0 +1,211 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/any_stream.hpp>
+#include <libstream/buffered.hpp>
+#include <libstream/framing.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+SCENARIO("Type erased read streams.")
+{
+    read_mock reader;
+
+    GIVEN("A referenced read stream.")
+    {
+        any_read_stream<int> s{reader};
+
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        auto sender = s.read();
+
+        test_sync_read_submit(reader.sender_, sender, test_pair{1, 1});
+        test_async_read_submit(reader.sender_, sender, test_pair{1, 1});
+        test_async_read_submit(reader.sender_, sender, test_pair{1, 1},
+                               dummy_error);
+
+        WHEN("The sender is moved.")
+        {
+            auto moved = std::move(sender);
+            test_sync_read_submit(reader.sender_, moved, test_pair{2, 2});
+        }
+    }
+
+    GIVEN("An adaptor moved into the stream.")
+    {
+        any_read_stream<int> s{
+            transform_read(reader, [](int v) { return v * 2; })};
+
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        auto sender = s.read();
+
+        test_sync_read_submit(reader.sender_, sender, test_pair{1, 2});
+        test_async_read_submit(reader.sender_, sender, test_pair{1, 2});
+
+        WHEN("The stream is moved.")
+        {
+            any_read_stream<int> moved{std::move(s)};
+            REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+            auto moved_sender = moved.read();
+            test_sync_read_submit(reader.sender_, moved_sender,
+                                  test_pair{3, 6});
+        }
+    }
+
+    GIVEN("A range read.")
+    {
+        any_read_stream<int> s{reader};
+
+        REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 2});
+        array<int, 2> a{};
+        auto          sender = s.read(a);
+
+        REQUIRE(a == array{1, 2});
+        test_sync_submit(reader.range_sender_, sender);
+        test_async_range_submit(reader.range_sender_, sender);
+    }
+}
+
+SCENARIO("Type erased write streams.")
+{
+    write_mock writer;
+
+    GIVEN("A referenced write stream.")
+    {
+        any_write_stream<int> s{writer};
+
+        REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_);
+        auto sender = s.write(1);
+
+        test_sync_submit(writer.sender_, sender);
+        test_async_write_submit(writer.sender_, sender);
+        test_async_write_submit(writer.sender_, sender, dummy_error);
+    }
+
+    GIVEN("A range write.")
+    {
+        any_write_stream<int> s{writer};
+        vector<int>           v{1, 2, 3};
+
+        REQUIRE_CALL(writer, write_(vector{1, 2, 3}));
+        auto sender = s.write(v);
+
+        test_sync_submit(writer.range_sender_, sender);
+        test_async_range_submit(writer.range_sender_, sender);
+    }
+}
+
+SCENARIO("Type erased adaptors which keep the range in their sender.")
+{
+    GIVEN("A buffered read stream.")
+    {
+        read_mock                 reader;
+        any_read_stream<int, 256> s{buffered_read<int>(reader, 4)};
+
+        int next = 1;
+        ALLOW_CALL(reader, read_(_))
+            .LR_SIDE_EFFECT(_1 = vector{next, next + 1}; next += 2);
+        ALLOW_CALL(reader.range_sender_, submit());
+
+        WHEN("A range is read after the sender was created.")
+        {
+            array<int, 3> a{};
+            auto          sender = s.read(a);
+            sender.submit();
+
+            THEN("The values are copied into the range.")
+            {
+                REQUIRE(a == array{1, 2, 3});
+            }
+        }
+    }
+
+    GIVEN("A buffered write stream.")
+    {
+        write_mock                 writer;
+        any_write_stream<int, 256> s{buffered_write<int>(writer, 8, 8)};
+
+        WHEN("A range is written after the sender was created.")
+        {
+            array<int, 3> a{1, 2, 3};
+            auto          sender = s.write(a);
+            sender.submit();
+
+            THEN("The values are taken from the range.")
+            {
+                REQUIRE_CALL(writer, write_(vector{1, 2, 3}));
+                REQUIRE_CALL(writer.range_sender_, submit());
+                auto flush = s.flush();
+                flush.submit();
+            }
+        }
+    }
+
+    GIVEN("A COBS decoding read stream.")
+    {
+        read_mock                 reader;
+        any_read_stream<int, 256> s{cobs_decode_read(reader)};
+
+        vector<int> wire{3, 0x11, 0x22, 2, 0x33, 0};
+        size_t      i = 0;
+        ALLOW_CALL(reader, read()).LR_RETURN(reader.sender_);
+        ALLOW_CALL(reader.sender_, submit()).LR_RETURN(wire[i++]);
+        ALLOW_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .LR_SIDE_EFFECT(_1.done(wire[i++]));
+
+        done_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        WHEN("A frame is read synchronously.")
+        {
+            array<int, 4> a{};
+            auto          sender = s.read(a);
+            sender.submit();
+
+            THEN("It is decoded into the range.")
+            {
+                REQUIRE(a == array{0x11, 0x22, 0, 0x33});
+            }
+        }
+
+        WHEN("A frame is read asynchronously.")
+        {
+            array<int, 4> a{};
+            auto          sender = s.read(a);
+
+            REQUIRE_CALL(callback_mock, call());
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+
+            THEN("It is decoded into the range.")
+            {
+                REQUIRE(a == array{0x11, 0x22, 0, 0x33});
+            }
+        }
+
+        WHEN("A single value is read.")
+        {
+            read_callback_mock value_mock;
+            REQUIRE_CALL(error_mock, call(static_cast<error_code>(
+                                         errc::operation_not_supported)));
+            s.read().submit(read_token<int>{error_mock, cancel_mock,
+                                            value_mock});
+        }
+    }
+}
@@ -0,0 +1,952 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_BUFFERED_HPP_
+#define LIBSTREAM_BUFFERED_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/span.hpp>
+#include <libstream/work_item.hpp>
+
+#include <experimental/ranges/range>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Operation waiting in the queue of a buffer. resume_ returns true once the
+ * operation has invoked its token.
+ */
+struct buffer_waiter
+{
+    bool (*resume_)(buffer_waiter*)           = nullptr;
+    void (*fail_)(buffer_waiter*, error_code) = nullptr;
+    buffer_waiter* next_                      = nullptr;
+};
+
+constexpr std::size_t at_least_one(std::size_t capacity)
+{
+    return capacity > 1 ? capacity : 1;
+}
+
+/*!
+ * FIFO of waiting operations.
+ */
+class waiter_queue
+{
+    buffer_waiter* head_ = nullptr;
+    buffer_waiter* tail_ = nullptr;
+
+    buffer_waiter* pop()
+    {
+        auto* w = head_;
+        head_   = w->next_;
+        if(head_ == nullptr) { tail_ = nullptr; }
+        return w;
+    }
+
+  public:
+    bool empty() const noexcept { return head_ == nullptr; }
+
+    /*!
+     * Resumes w immediately if no other operation is waiting, otherwise
+     * queues it behind them.
+     */
+    void submit(buffer_waiter& w)
+    {
+        if(head_ == nullptr && w.resume_(&w)) { return; }
+        w.next_ = nullptr;
+        if(tail_ == nullptr) { head_ = &w; }
+        else
+        {
+            tail_->next_ = &w;
+        }
+        tail_ = &w;
+    }
+
+    /*!
+     * Returns false if w was not waiting.
+     */
+    bool remove(buffer_waiter& w)
+    {
+        buffer_waiter* previous = nullptr;
+        for(auto* i = head_; i != nullptr; previous = i, i = i->next_)
+        {
+            if(i != &w) { continue; }
+            if(previous == nullptr) { head_ = i->next_; }
+            else
+            {
+                previous->next_ = i->next_;
+            }
+            if(tail_ == i) { tail_ = previous; }
+            return true;
+        }
+        return false;
+    }
+
+    /*!
+     * Resumes the waiting operations in order until one has to keep waiting.
+     * Operations are dequeued before they are resumed, as their token might
+     * end their lifetime.
+     */
+    void resume()
+    {
+        while(head_ != nullptr)
+        {
+            auto* w = pop();
+            if(!w->resume_(w))
+            {
+                w->next_ = head_;
+                head_    = w;
+                if(tail_ == nullptr) { tail_ = w; }
+                return;
+            }
+        }
+    }
+
+    void fail(error_code e)
+    {
+        while(head_ != nullptr)
+        {
+            auto* w = pop();
+            w->fail_(w, e);
+        }
+    }
+};
+
+/*!
+ * Ring buffer of a buffered_write_fn together with the stream it flushes to.
+ *
+ * At most one flush is in flight. It writes the buffered elements with one
+ * vectored write if the stream supports it, otherwise the contiguous part up
+ * to the end of the ring. Waiting operations are resumed in order whenever a
+ * flush completes.
+ */
+template<class S, class T> class write_buffer
+{
+    using this_t   = write_buffer<S, T>;
+    using segments = std::array<span<T>, 2>;
+
+    static constexpr bool vectored = VectoredWriteStreamable<S, segments&>;
+
+    static decltype(auto) make_child(std::remove_reference_t<S>& s,
+                                     segments&                   segs)
+    {
+        if constexpr(vectored) { return s.writev(segs); }
+        else
+        {
+            return s.write(segs[0]);
+        }
+    }
+
+    struct flush_timer : timer_item
+    {
+        this_t* owner_;
+
+        explicit flush_timer(this_t* owner)
+            : timer_item(&this_t::timer_handler), owner_(owner)
+        {
+        }
+    };
+
+    S                    stream_;
+    std::unique_ptr<T[]> data_;
+    std::size_t          capacity_;
+    std::size_t          threshold_;
+    std::size_t          head_     = 0;
+    std::size_t          size_     = 0;
+    std::size_t          flushing_ = 0;
+    std::uint64_t        written_  = 0;
+
+    segments segments_;
+    sender_slot<decltype(
+        make_child(std::declval<S&>(), std::declval<segments&>()))>
+               child_;
+    trampoline trampoline_;
+    bool       flush_requested_ = false;
+
+    waiter_queue waiters_;
+
+    flush_timer              timer_{this};
+    bool                     timer_armed_ = false;
+    void*                    loop_        = nullptr;
+    std::chrono::nanoseconds latency_{};
+    void (*arm_)(void*, timer_item&, std::chrono::nanoseconds) = nullptr;
+    void (*disarm_)(void*, timer_item&)                         = nullptr;
+
+    static void timer_handler(work_item* w)
+    {
+        auto& self        = *static_cast<flush_timer*>(w)->owner_;
+        self.timer_armed_ = false;
+        if(self.size_ > 0)
+        {
+            self.flush_requested_ = true;
+            self.kick();
+        }
+    }
+
+    void prepare_flush()
+    {
+        auto first   = std::min(size_, capacity_ - head_);
+        segments_[0] = span<T>{data_.get() + head_, first};
+        segments_[1] = span<T>{data_.get(), size_ - first};
+        flushing_    = vectored ? size_ : first;
+        child_.emplace(make_child(stream_, segments_));
+    }
+
+    void arm_timer()
+    {
+        if(loop_ == nullptr || timer_armed_) { return; }
+        timer_armed_ = true;
+        arm_(loop_, timer_, latency_);
+    }
+
+    /*
+     * Only successfully flushed elements count as written, failed ones are
+     * dropped. Elements buffered while the flush was in flight get a timer
+     * of their own.
+     */
+    void release_flushed(bool written)
+    {
+        head_ = (head_ + flushing_) % capacity_;
+        size_ -= flushing_;
+        if(written) { written_ += flushing_; }
+        flushing_ = 0;
+        if(size_ > 0) { arm_timer(); }
+    }
+
+    void start_flush()
+    {
+        if(flushing_ > 0) { return; }
+        if(size_ == 0)
+        {
+            flush_requested_ = false;
+            return;
+        }
+        if(size_ < threshold_ && !flush_requested_ && waiters_.empty())
+        {
+            return;
+        }
+
+        prepare_flush();
+        // A wrapped ring is flushed in two parts to streams without vectored
+        // writes, the request stays pending for the second one.
+        if(flushing_ == size_) { flush_requested_ = false; }
+        child_->submit(base_token{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            done_token::template create<this_t, &this_t::done_handler>(
+                this)});
+    }
+
+    void kick()
+    {
+        trampoline_.run(child_, [this] { start_flush(); });
+    }
+
+    void done_handler()
+    {
+        release_flushed(true);
+        waiters_.resume();
+        kick();
+    }
+
+    void error_handler(error_code e)
+    {
+        release_flushed(false);
+        waiters_.fail(e);
+        kick();
+    }
+
+    void cancel_handler()
+    {
+        error_handler(static_cast<error_code>(std::errc::operation_canceled));
+    }
+
+  public:
+    write_buffer(S&& stream, std::size_t capacity, std::size_t threshold)
+        : stream_(std::forward<S>(stream)),
+          data_(new T[at_least_one(capacity)]),
+          capacity_(at_least_one(capacity)), threshold_(threshold)
+    {
+    }
+
+    write_buffer(const write_buffer&) = delete;
+    write_buffer& operator=(const write_buffer&) = delete;
+
+    ~write_buffer()
+    {
+        if(timer_armed_) { disarm_(loop_, timer_); }
+    }
+
+    template<class Loop>
+    void flush_after(Loop& loop, std::chrono::nanoseconds latency)
+    {
+        loop_    = &loop;
+        latency_ = latency;
+        arm_     = [](void* l, timer_item& t, std::chrono::nanoseconds d) {
+            static_cast<Loop*>(l)->schedule_after(t, d);
+        };
+        disarm_ = [](void* l, timer_item& t) {
+            static_cast<Loop*>(l)->cancel(t);
+        };
+    }
+
+    std::uint64_t written() const noexcept { return written_; }
+    std::size_t   size() const noexcept { return size_; }
+
+    /*!
+     * Returns false if the buffer is full.
+     */
+    template<class V> bool push(V&& v)
+    {
+        if(size_ == capacity_) { return false; }
+        if(size_ == 0) { arm_timer(); }
+
+        auto index = head_ + size_;
+        if(index >= capacity_) { index -= capacity_; }
+        data_[index] = std::forward<V>(v);
+        ++size_;
+        return true;
+    }
+
+    /*!
+     * Resumes w immediately if no other operation is waiting, otherwise
+     * queues it behind them. A flush is started if the threshold is reached
+     * or an operation has to wait.
+     */
+    void enqueue(buffer_waiter& w)
+    {
+        waiters_.submit(w);
+        kick();
+    }
+
+    bool remove(buffer_waiter& w) { return waiters_.remove(w); }
+
+    /*!
+     * Writes all buffered elements with synchronous submits.
+     */
+    void flush()
+    {
+        while(size_ > 0)
+        {
+            prepare_flush();
+            child_->submit();
+            release_flushed(true);
+        }
+    }
+
+    void flush_if_full()
+    {
+        if(size_ >= threshold_) { flush(); }
+    }
+};
+
+constexpr std::size_t half(std::size_t capacity)
+{
+    return capacity > 1 ? capacity / 2 : 1;
+}
+
+template<class T> struct value_source
+{
+    T    value_;
+    bool copied_ = false;
+
+    void rewind() { copied_ = false; }
+
+    template<class Buffer> bool copy_to(Buffer& b)
+    {
+        if(!copied_) { copied_ = b.push(value_); }
+        return copied_;
+    }
+};
+
+template<class R> class range_source
+{
+    using iterator =
+        std::experimental::ranges::iterator_t<std::remove_reference_t<R>>;
+
+    R        range_;
+    iterator current_{};
+
+  public:
+    explicit range_source(R&& r) : range_(std::forward<R>(r)) {}
+
+    void rewind() { current_ = std::experimental::ranges::begin(range_); }
+
+    template<class Buffer> bool copy_to(Buffer& b)
+    {
+        auto end = std::experimental::ranges::end(range_);
+        while(current_ != end && b.push(*current_)) { ++current_; }
+        return current_ == end;
+    }
+};
+
+/*!
+ * Copies the source into the buffer. Completes once everything is buffered,
+ * which only waits for a flush if the buffer is full.
+ */
+template<class Buffer, class Source>
+class buffered_write_context : buffer_waiter
+{
+    using this_t = buffered_write_context<Buffer, Source>;
+
+    Buffer&    buffer_;
+    Source     source_;
+    base_token token_;
+
+    static bool resume_handler(buffer_waiter* w)
+    {
+        auto& self = *static_cast<this_t*>(w);
+        if(!self.source_.copy_to(self.buffer_)) { return false; }
+        self.token_.done();
+        return true;
+    }
+
+    static void fail_handler(buffer_waiter* w, error_code e)
+    {
+        static_cast<this_t*>(w)->token_.error(e);
+    }
+
+  public:
+    buffered_write_context(Buffer& buffer, Source&& source)
+        : buffer_waiter{&this_t::resume_handler, &this_t::fail_handler},
+          buffer_(buffer), source_(std::move(source))
+    {
+    }
+
+    void submit()
+    {
+        source_.rewind();
+        while(!source_.copy_to(buffer_)) { buffer_.flush(); }
+        buffer_.flush_if_full();
+    }
+
+    void submit(base_token&& t)
+    {
+        token_ = t;
+        source_.rewind();
+        buffer_.enqueue(*this);
+    }
+
+    /*!
+     * Elements which were already buffered are still written.
+     */
+    void cancel()
+    {
+        if(buffer_.remove(*this)) { token_.cancelled(); }
+    }
+};
+
+/*!
+ * Completes once all elements buffered before the submit are written.
+ */
+template<class Buffer> class buffered_flush_context : buffer_waiter
+{
+    using this_t = buffered_flush_context<Buffer>;
+
+    Buffer&       buffer_;
+    std::uint64_t target_ = 0;
+    base_token    token_;
+
+    static bool resume_handler(buffer_waiter* w)
+    {
+        auto& self = *static_cast<this_t*>(w);
+        if(self.buffer_.written() < self.target_) { return false; }
+        self.token_.done();
+        return true;
+    }
+
+    static void fail_handler(buffer_waiter* w, error_code e)
+    {
+        static_cast<this_t*>(w)->token_.error(e);
+    }
+
+  public:
+    explicit buffered_flush_context(Buffer& buffer)
+        : buffer_waiter{&this_t::resume_handler, &this_t::fail_handler},
+          buffer_(buffer)
+    {
+    }
+
+    void submit() { buffer_.flush(); }
+
+    void submit(base_token&& t)
+    {
+        token_  = t;
+        target_ = buffer_.written() + buffer_.size();
+        buffer_.enqueue(*this);
+    }
+
+    void cancel()
+    {
+        if(buffer_.remove(*this)) { token_.cancelled(); }
+    }
+};
+} // namespace detail
+
+/*!
+ * Collects written values in a ring buffer of fixed capacity and writes them
+ * to the underlying stream in bulk.
+ *
+ * A write completes as soon as its elements are buffered. The buffer is
+ * flushed with a single range write, or a vectored write if the stream
+ * supports it, once it holds threshold elements, when flush() is submitted,
+ * or after the latency given to flush_after(). Writes only wait while the
+ * buffer is full. A failed flush reports its error to all waiting operations
+ * and the flushed elements are dropped. A capacity of 0 is treated as 1.
+ *
+ * The stream is not thread-safe. Synchronous and asynchronous submits must
+ * not be mixed while an asynchronous flush is in flight.
+ */
+template<PureWriteStreamable S, class T> class buffered_write_fn
+{
+    using buffer_t = detail::write_buffer<S, T>;
+
+    std::unique_ptr<buffer_t> buffer_;
+
+  public:
+    buffered_write_fn(S&& stream, std::size_t capacity, std::size_t threshold)
+        : buffer_(std::make_unique<buffer_t>(std::forward<S>(stream),
+                                             capacity, threshold))
+    {
+    }
+
+    template<class V> auto write(V&& v) const
+    {
+        return detail::buffered_write_context<buffer_t,
+                                              detail::value_source<T>>{
+            *buffer_, {T(std::forward<V>(v))}};
+    }
+
+    template<std::experimental::ranges::InputRange R> auto write(R&& r) const
+    {
+        return detail::buffered_write_context<buffer_t,
+                                              detail::range_source<R>>{
+            *buffer_, detail::range_source<R>{std::forward<R>(r)}};
+    }
+
+    auto flush() const
+    {
+        return detail::buffered_flush_context<buffer_t>{*buffer_};
+    }
+
+    /*!
+     * Flushes elements at the latest latency after the first of them was
+     * buffered, using a timer of loop.
+     */
+    template<class Loop, class Rep, class Period>
+    void flush_after(Loop& loop, std::chrono::duration<Rep, Period> latency)
+    {
+        buffer_->flush_after(
+            loop,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency));
+    }
+
+    /*!
+     * Number of buffered elements which are not written yet.
+     */
+    std::size_t size() const noexcept { return buffer_->size(); }
+};
+
+template<class T> class buffered_write_pipe
+{
+    std::size_t capacity_;
+    std::size_t threshold_;
+
+  public:
+    constexpr buffered_write_pipe(std::size_t capacity, std::size_t threshold)
+        : capacity_(capacity), threshold_(threshold)
+    {
+    }
+
+    template<PureWriteStreamable S> WriteStreamable pipe(S&& s) const
+    {
+        return buffered_write_fn<S, T>{std::forward<S>(s), capacity_,
+                                       threshold_};
+    }
+};
+
+/*!
+ * By default a flush starts at half the capacity, so writes can fill the
+ * other half while it is in flight.
+ */
+template<class T>
+Pipeable buffered_write(std::size_t capacity, std::size_t threshold = 0)
+{
+    return buffered_write_pipe<T>{
+        capacity, threshold != 0 ? threshold : detail::half(capacity)};
+}
+
+template<class T, PureWriteStreamable S>
+WriteStreamable buffered_write(S&& stream, std::size_t capacity,
+                               std::size_t threshold = 0)
+{
+    return buffered_write_fn<S, T>{
+        std::forward<S>(stream), capacity,
+        threshold != 0 ? threshold : detail::half(capacity)};
+}
+
+namespace detail
+{
+/*!
+ * Two blocks of a buffered_read_fn together with the stream they are filled
+ * from.
+ *
+ * Values are served from the current block while the other block is filled
+ * by a range read of the stream. Once the current block is consumed the
+ * blocks are swapped and the next range read is started, so one read is
+ * always in flight after the first asynchronous read.
+ */
+template<class S, class T> class read_buffer
+{
+    using this_t = read_buffer<S, T>;
+
+    S                    stream_;
+    std::unique_ptr<T[]> data_;
+    std::size_t          block_size_;
+    std::size_t          current_  = 0;
+    std::size_t          position_ = 0;
+    std::size_t          end_      = 0;
+    bool                 filled_   = false;
+    bool                 fetching_ = false;
+
+    span<T> target_;
+    sender_slot<decltype(std::declval<S&>().read(std::declval<span<T>&>()))>
+                 child_;
+    trampoline   trampoline_;
+    waiter_queue waiters_;
+
+    T* block(std::size_t i) { return data_.get() + i * block_size_; }
+
+    void prepare_fetch()
+    {
+        target_ = span<T>{block(current_ ^ 1), block_size_};
+        child_.emplace(stream_.read(target_));
+    }
+
+    void start_fetch()
+    {
+        if(fetching_ || filled_) { return; }
+
+        fetching_ = true;
+        prepare_fetch();
+        child_->submit(base_token{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            done_token::template create<this_t, &this_t::done_handler>(
+                this)});
+    }
+
+    void kick()
+    {
+        trampoline_.run(child_, [this] { start_fetch(); });
+    }
+
+    void done_handler()
+    {
+        fetching_ = false;
+        filled_   = true;
+        waiters_.resume();
+        kick();
+    }
+
+    /*
+     * The read ahead stops after an error, the next read starts it again.
+     */
+    void error_handler(error_code e)
+    {
+        fetching_ = false;
+        waiters_.fail(e);
+    }
+
+    void cancel_handler()
+    {
+        error_handler(static_cast<error_code>(std::errc::operation_canceled));
+    }
+
+    /*!
+     * Switches to the filled block once the current one is consumed. Returns
+     * false if no value is buffered.
+     */
+    bool next_block()
+    {
+        if(position_ != end_) { return true; }
+        if(!filled_) { return false; }
+        current_ ^= 1;
+        position_ = 0;
+        end_      = block_size_;
+        filled_   = false;
+        return true;
+    }
+
+  public:
+    read_buffer(S&& stream, std::size_t block_size)
+        : stream_(std::forward<S>(stream)), data_(new T[2 * block_size]),
+          block_size_(block_size)
+    {
+    }
+
+    read_buffer(const read_buffer&) = delete;
+    read_buffer& operator=(const read_buffer&) = delete;
+
+    /*!
+     * Returns false if no value is buffered.
+     */
+    bool pop(T& v)
+    {
+        if(!next_block()) { return false; }
+        v = block(current_)[position_++];
+        return true;
+    }
+
+    /*!
+     * Buffered values which are stored contiguously, empty if no value is
+     * buffered. They stay buffered until consume() is called.
+     */
+    span<const T> front()
+    {
+        if(!next_block()) { return {}; }
+        return {block(current_) + position_, end_ - position_};
+    }
+
+    /*!
+     * Removes the first n values of front().
+     */
+    void consume(std::size_t n) { position_ += n; }
+
+    /*!
+     * Number of buffered values.
+     */
+    std::size_t size() const noexcept
+    {
+        return end_ - position_ + (filled_ ? block_size_ : 0);
+    }
+
+    /*!
+     * Resumes w immediately if values are buffered and no other operation is
+     * waiting, otherwise queues it behind them. Starts the read ahead if the
+     * other block is free.
+     */
+    void enqueue(buffer_waiter& w)
+    {
+        waiters_.submit(w);
+        kick();
+    }
+
+    bool remove(buffer_waiter& w) { return waiters_.remove(w); }
+
+    /*!
+     * Fills the other block with a synchronous submit.
+     */
+    void fill()
+    {
+        prepare_fetch();
+        child_->submit();
+        filled_ = true;
+    }
+};
+
+template<class T> struct value_sink
+{
+    using token_type = read_token<T>;
+
+    T value_;
+
+    void rewind() {}
+
+    template<class Buffer> bool copy_from(Buffer& b) { return b.pop(value_); }
+
+    T result() const { return value_; }
+
+    void report(token_type& t) { t.done(value_); }
+};
+
+template<class R, class T> class range_sink
+{
+    using iterator =
+        std::experimental::ranges::iterator_t<std::remove_reference_t<R>>;
+
+    R        range_;
+    iterator current_{};
+
+  public:
+    using token_type = base_token;
+
+    explicit range_sink(R&& r) : range_(std::forward<R>(r)) {}
+
+    void rewind() { current_ = std::experimental::ranges::begin(range_); }
+
+    template<class Buffer> bool copy_from(Buffer& b)
+    {
+        auto end = std::experimental::ranges::end(range_);
+        T    v;
+        while(current_ != end && b.pop(v))
+        {
+            *current_ = v;
+            ++current_;
+        }
+        return current_ == end;
+    }
+
+    void result() const {}
+
+    void report(token_type& t) { t.done(); }
+};
+
+/*!
+ * Takes the values from the buffer. Completes immediately if enough values
+ * are buffered, otherwise once the read ahead has delivered them.
+ */
+template<class Buffer, class Sink>
+class buffered_read_context : buffer_waiter
+{
+    using this_t  = buffered_read_context<Buffer, Sink>;
+    using token_t = typename Sink::token_type;
+
+    Buffer& buffer_;
+    Sink    sink_;
+    token_t token_;
+
+    static bool resume_handler(buffer_waiter* w)
+    {
+        auto& self = *static_cast<this_t*>(w);
+        if(!self.sink_.copy_from(self.buffer_)) { return false; }
+        self.sink_.report(self.token_);
+        return true;
+    }
+
+    static void fail_handler(buffer_waiter* w, error_code e)
+    {
+        static_cast<this_t*>(w)->token_.error(e);
+    }
+
+  public:
+    buffered_read_context(Buffer& buffer, Sink&& sink)
+        : buffer_waiter{&this_t::resume_handler, &this_t::fail_handler},
+          buffer_(buffer), sink_(std::move(sink))
+    {
+    }
+
+    auto submit()
+    {
+        sink_.rewind();
+        while(!sink_.copy_from(buffer_)) { buffer_.fill(); }
+        return sink_.result();
+    }
+
+    void submit(token_t&& t)
+    {
+        token_ = t;
+        sink_.rewind();
+        buffer_.enqueue(*this);
+    }
+
+    /*!
+     * Number of values taken by a sink which may stop before its range is
+     * filled. Valid after the read completed.
+     */
+    auto size() const noexcept { return sink_.size(); }
+
+    /*!
+     * Values which were already taken from the buffer are lost.
+     */
+    void cancel()
+    {
+        if(buffer_.remove(*this)) { token_.cancelled(); }
+    }
+};
+} // namespace detail
+
+/*!
+ * Reads values from the underlying stream in blocks of half the capacity and
+ * serves reads from them.
+ *
+ * While values are taken from one block, a range read of the underlying
+ * stream fills the other one, so its latency is hidden behind the
+ * consumption of the buffered values. Reads only wait if both blocks are
+ * exhausted. An error of the read ahead is reported to all waiting reads.
+ *
+ * The stream is not thread-safe. Synchronous reads never start a read ahead
+ * and must not be mixed with asynchronous ones while it is in flight.
+ */
+template<PureReadStreamable S, class T> class buffered_read_fn
+{
+    using buffer_t = detail::read_buffer<S, T>;
+
+    std::unique_ptr<buffer_t> buffer_;
+
+  public:
+    buffered_read_fn(S&& stream, std::size_t capacity)
+        : buffer_(std::make_unique<buffer_t>(std::forward<S>(stream),
+                                             detail::half(capacity)))
+    {
+    }
+
+    auto read() const
+    {
+        return detail::buffered_read_context<buffer_t, detail::value_sink<T>>{
+            *buffer_, {}};
+    }
+
+    template<std::experimental::ranges::Range R> auto read(R&& r) const
+    {
+        return detail::buffered_read_context<buffer_t,
+                                             detail::range_sink<R, T>>{
+            *buffer_, detail::range_sink<R, T>{std::forward<R>(r)}};
+    }
+
+    /*!
+     * Number of buffered values which are not read yet.
+     */
+    std::size_t size() const noexcept { return buffer_->size(); }
+};
+
+template<class T> class buffered_read_pipe
+{
+    std::size_t capacity_;
+
+  public:
+    constexpr buffered_read_pipe(std::size_t capacity) : capacity_(capacity)
+    {
+    }
+
+    template<PureReadStreamable S> ReadStreamable pipe(S&& s) const
+    {
+        return buffered_read_fn<S, T>{std::forward<S>(s), capacity_};
+    }
+};
+
+template<class T> Pipeable buffered_read(std::size_t capacity)
+{
+    return buffered_read_pipe<T>{capacity};
+}
+
+template<class T, PureReadStreamable S>
+ReadStreamable buffered_read(S&& stream, std::size_t capacity)
+{
+    return buffered_read_fn<S, T>{std::forward<S>(stream), capacity};
+}
+
+} // namespace stream
+
+#endif // LIBSTREAM_BUFFERED_HPP_
@@ -0,0 +1,421 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/buffered.hpp>
+
+#include <libstream/run_loop.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+struct manual_clock
+{
+    using rep        = long;
+    using period     = std::milli;
+    using duration   = std::chrono::milliseconds;
+    using time_point = std::chrono::time_point<manual_clock>;
+
+    static constexpr bool is_steady = true;
+    static inline long    now_      = 0;
+
+    static time_point now() { return time_point{duration{now_}}; }
+};
+
+/*
+ * Range read stream which returns its senders by value. A sender touches its
+ * own state after its completion handler returned, like a sender which owns
+ * an operation of an event loop.
+ */
+struct owning_reader
+{
+    struct sender
+    {
+        owning_reader*  stream_;
+        span<int>       range_;
+        unique_ptr<int> completions_ = make_unique<int>(0);
+        base_token      token_;
+
+        void submit() {}
+        void submit(base_token&& t)
+        {
+            token_            = t;
+            stream_->pending_ = this;
+        }
+        void cancel() {}
+
+        void complete()
+        {
+            auto* completions = completions_.get();
+            stream_->pending_ = nullptr;
+            for(auto& v : range_) { v = stream_->next_++; }
+            token_.done();
+            ++*completions;
+        }
+    };
+
+    int     next_    = 1;
+    sender* pending_ = nullptr;
+
+    sender read(span<int>& r) { return sender{this, r}; }
+};
+} // namespace
+
+SCENARIO("Buffered writes.")
+{
+    GIVEN("A write stream buffered with capacity 4 and threshold 2.")
+    {
+        write_mock writer;
+        auto       s = buffered_write<int>(writer, 4, 2);
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        done_callback_mock   done_mock;
+
+        WHEN("A single value is written synchronously.")
+        {
+            s.write(1).submit();
+
+            THEN("It is only buffered.") { REQUIRE(s.size() == 1); }
+
+            AND_WHEN("The stream is flushed.")
+            {
+                REQUIRE_CALL(writer, write_(vector{1}));
+                REQUIRE_CALL(writer.range_sender_, submit());
+                s.flush().submit();
+                REQUIRE(s.size() == 0);
+            }
+        }
+
+        WHEN("Values are written synchronously up to the threshold.")
+        {
+            THEN("They are written with a single range write.")
+            {
+                REQUIRE_CALL(writer, write_(vector{1, 2}));
+                REQUIRE_CALL(writer.range_sender_, submit());
+                s.write(1).submit();
+                s.write(2).submit();
+                REQUIRE(s.size() == 0);
+            }
+        }
+
+        WHEN("A range is written asynchronously.")
+        {
+            base_token t;
+            REQUIRE_CALL(writer, write_(vector{1, 2, 3}));
+            REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t = _1);
+            REQUIRE_CALL(done_mock, call());
+
+            array a{1, 2, 3};
+            auto  sender = s.write(a);
+            sender.submit(base_token{error_mock, cancel_mock, done_mock});
+
+            THEN("It completes as soon as it is buffered.")
+            {
+                REQUIRE(s.size() == 3);
+            }
+
+            AND_WHEN("A flush is submitted while the write is in flight.")
+            {
+                done_callback_mock flush_done;
+                auto               flush = s.flush();
+                flush.submit(base_token{error_mock, cancel_mock, flush_done});
+
+                THEN("The flush completes with the write.")
+                {
+                    REQUIRE_CALL(flush_done, call());
+                    t.done();
+                }
+            }
+
+            AND_WHEN("The write fails.")
+            {
+                error_callback_mock flush_error;
+                auto                flush = s.flush();
+                flush.submit(base_token{flush_error, cancel_mock, done_mock});
+
+                THEN("The error is reported to the waiting flush.")
+                {
+                    REQUIRE_CALL(flush_error, call(dummy_error));
+                    t.error(dummy_error);
+                    REQUIRE(s.size() == 0);
+                }
+            }
+        }
+
+        WHEN("The buffer is full while a flush is in flight.")
+        {
+            base_token t;
+            REQUIRE_CALL(writer, write_(vector{1, 2, 3, 4}));
+            REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t = _1);
+
+            array a{1, 2, 3, 4};
+            auto  first = s.write(a);
+            REQUIRE_CALL(done_mock, call());
+            first.submit(base_token{error_mock, cancel_mock, done_mock});
+
+            done_callback_mock waiting_done;
+            auto               second = s.write(5);
+            second.submit(base_token{error_mock, cancel_mock, waiting_done});
+
+            THEN("The write waits until the flush completes.")
+            {
+                REQUIRE(s.size() == 4);
+                REQUIRE_CALL(waiting_done, call());
+                t.done();
+                REQUIRE(s.size() == 1);
+            }
+
+            THEN("The waiting write can be cancelled.")
+            {
+                REQUIRE_CALL(cancel_mock, call());
+                second.cancel();
+            }
+        }
+    }
+
+    GIVEN("A buffered stream which is flushed by a timer.")
+    {
+        manual_clock::now_ = 0;
+        write_mock                   writer;
+        basic_run_loop<manual_clock> loop;
+
+        auto s = buffered_write<int>(writer, 4);
+        s.flush_after(loop, std::chrono::milliseconds(5));
+
+        WHEN("A value is buffered.")
+        {
+            s.write(1).submit();
+
+            THEN("It is written once the latency has passed.")
+            {
+                manual_clock::now_ = 4;
+                loop.run_once();
+                REQUIRE(s.size() == 1);
+
+                REQUIRE_CALL(writer, write_(vector{1}));
+                REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                    .SIDE_EFFECT(_1.done());
+                manual_clock::now_ = 6;
+                loop.run_once();
+                REQUIRE(s.size() == 0);
+            }
+        }
+
+        WHEN("A value is buffered while the timed flush is in flight.")
+        {
+            base_token t;
+            REQUIRE_CALL(writer, write_(vector{1}));
+            REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t = _1);
+            s.write(1).submit();
+            manual_clock::now_ = 6;
+            loop.run_once();
+
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+            done_callback_mock   done_mock;
+            REQUIRE_CALL(done_mock, call());
+            auto sender = s.write(2);
+            sender.submit(base_token{error_mock, cancel_mock, done_mock});
+            t.done();
+
+            THEN("It is written once the latency after the flush has passed.")
+            {
+                manual_clock::now_ = 10;
+                loop.run_once();
+                REQUIRE(s.size() == 1);
+
+                REQUIRE_CALL(writer, write_(vector{2}));
+                REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                    .SIDE_EFFECT(_1.done());
+                manual_clock::now_ = 12;
+                loop.run_once();
+                REQUIRE(s.size() == 0);
+            }
+        }
+    }
+
+    GIVEN("A buffered stream with a wrapped ring which is flushed by a timer.")
+    {
+        manual_clock::now_ = 0;
+        write_mock                   writer;
+        basic_run_loop<manual_clock> loop;
+
+        auto s = buffered_write<int>(writer, 4, 4);
+        s.flush_after(loop, std::chrono::milliseconds(5));
+
+        {
+            REQUIRE_CALL(writer, write_(vector{1, 2, 3}));
+            REQUIRE_CALL(writer.range_sender_, submit());
+            array a{1, 2, 3};
+            s.write(a).submit();
+            s.flush().submit();
+        }
+        s.write(4).submit();
+        s.write(5).submit();
+
+        WHEN("The latency has passed.")
+        {
+            REQUIRE_CALL(writer, write_(vector{4}));
+            REQUIRE_CALL(writer, write_(vector{5}));
+            REQUIRE_CALL(writer.range_sender_, submit(ANY(base_token)))
+                .TIMES(2)
+                .SIDE_EFFECT(_1.done());
+            manual_clock::now_ = 6;
+            loop.run_once();
+
+            THEN("Both parts of the ring are written.")
+            {
+                REQUIRE(s.size() == 0);
+            }
+        }
+    }
+
+    GIVEN("A write stream buffered with capacity 0.")
+    {
+        write_mock writer;
+        auto       s = buffered_write<int>(writer, 0);
+
+        WHEN("A value is written synchronously.")
+        {
+            THEN("It is written as with capacity 1.")
+            {
+                REQUIRE_CALL(writer, write_(vector{1}));
+                REQUIRE_CALL(writer.range_sender_, submit());
+                s.write(1).submit();
+                REQUIRE(s.size() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Buffered reads.")
+{
+    GIVEN("A read stream buffered in blocks of 2.")
+    {
+        read_mock reader;
+        auto      s = buffered_read<int>(reader, 4);
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_callback_mock   value_mock;
+
+        WHEN("Values are read synchronously.")
+        {
+            THEN("A block is read once and served from the buffer.")
+            {
+                REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 2});
+                REQUIRE_CALL(reader.range_sender_, submit());
+                REQUIRE(s.read().submit() == 1);
+                REQUIRE(s.read().submit() == 2);
+                REQUIRE(s.size() == 0);
+            }
+        }
+
+        WHEN("A value is read asynchronously.")
+        {
+            int        next = 1;
+            base_token t;
+            REQUIRE_CALL(reader, read_(_))
+                .TIMES(1, 3)
+                .LR_SIDE_EFFECT(_1 = vector{next, next + 1}; next += 2);
+            REQUIRE_CALL(reader.range_sender_, submit(ANY(base_token)))
+                .TIMES(1, 3)
+                .LR_SIDE_EFFECT(t = _1);
+
+            auto r = s.read();
+            r.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+
+            THEN("It completes with the block and the next one is read ahead.")
+            {
+                REQUIRE_CALL(value_mock, call(1));
+                t.done();
+                REQUIRE(next == 5);
+
+                REQUIRE_CALL(value_mock, call(2));
+                r.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+                REQUIRE(s.size() == 0);
+
+                r.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+                REQUIRE_CALL(value_mock, call(3));
+                t.done();
+                REQUIRE(s.size() == 1);
+            }
+
+            THEN("A range read waits for the read ahead.")
+            {
+                REQUIRE_CALL(value_mock, call(1));
+                t.done();
+
+                done_callback_mock done_mock;
+                array<int, 3>      a{};
+                auto               range_reader = s.read(a);
+                range_reader.submit(
+                    base_token{error_mock, cancel_mock, done_mock});
+
+                REQUIRE_CALL(done_mock, call());
+                t.done();
+                REQUIRE(a == array{2, 3, 4});
+            }
+
+            THEN("A failed read is reported to the waiting read.")
+            {
+                REQUIRE_CALL(error_mock, call(dummy_error));
+                t.error(dummy_error);
+            }
+
+            THEN("The waiting read can be cancelled.")
+            {
+                REQUIRE_CALL(cancel_mock, call());
+                r.cancel();
+            }
+        }
+    }
+    GIVEN("A buffered stream whose reads complete asynchronously.")
+    {
+        owning_reader reader;
+        auto          s = buffered_read<int>(reader, 4);
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_callback_mock   value_mock;
+
+        auto r = s.read();
+        r.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+
+        WHEN("The read completes.")
+        {
+            REQUIRE_CALL(value_mock, call(1));
+            reader.pending_->complete();
+
+            THEN("The next block is read ahead from within the completion.")
+            {
+                REQUIRE(reader.pending_ != nullptr);
+                reader.pending_->complete();
+                REQUIRE(s.size() == 3);
+            }
+        }
+    }
+}
@@ -8,6 +8,8 @@
 #ifndef LIBSTREAM_CONCEPTS_EXECUTOR_HPP_
 #define LIBSTREAM_CONCEPTS_EXECUTOR_HPP_
 
+#include <libstream/work_item.hpp>
+
 #include <experimental/ranges/concepts>
 
 namespace stream
@@ -34,6 +36,11 @@ template<class F, class Ret, class... Args>
 concept bool Executable =
     AsyncInvokable<F, Ret, Args...> || SyncInvokable<F, Ret, Args...>;
 
+template<class E> concept bool Postable = requires(E& e, work_item& w)
+{
+    e.post(w);
+};
+
 } // namespace stream
 
 #endif // LIBSTREAM_CONCEPTS_EXECUTOR_HPP_
@@ -19,6 +19,16 @@ template<class P> concept bool Pipeable = requires()
     {std::remove_reference_t<P>::pipe};
 };
 
+/*!
+ * Read stage which can be merged with adjacent stages into one context.
+ */
+template<class P>
+concept bool FusableReadPipe =
+    Pipeable<P>&& requires(const std::remove_reference_t<P>& p)
+{
+    {p.read_ops()};
+};
+
 template<Streamable S, Pipeable P> concept bool PipeableTo = requires(S s, P p)
 {
     {p.pipe(s)};
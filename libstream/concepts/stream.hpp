@@ -9,6 +9,7 @@
 #define LIBSTREAM_CONCEPTS_STREAM_HPP_
 
 #include <type_traits>
+#include <utility>
 
 namespace stream
 {
@@ -36,6 +37,16 @@ template<class S>
 concept bool Streamable =
     PureReadStreamable<S> || PureWriteStreamable<S> || ReadWriteStreamable<S>;
 
+/*!
+ * A stream which writes a range of contiguous segments in one operation.
+ */
+template<class S, class Segments>
+concept bool VectoredWriteStreamable =
+    requires(const std::remove_reference_t<S>& s, Segments&& segments)
+{
+    s.writev(std::forward<Segments>(segments));
+};
+
 } // namespace stream
 
 #endif // LIBSTREAM_CONCEPTS_STREAM_HPP_
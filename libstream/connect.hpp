@@ -0,0 +1,112 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_CONNECT_HPP_
+#define LIBSTREAM_CONNECT_HPP_
+
+#include <libstream/callback.hpp>
+
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Token type of a sender whose synchronous submit returns T.
+ */
+template<class T> struct token_for
+{
+    using type = read_token<T>;
+};
+
+template<> struct token_for<void>
+{
+    using type = base_token;
+};
+
+template<class Token, class S, class R> class token_operation;
+
+/*!
+ * Connects a sender which only accepts tokens to a receiver. This is the only
+ * place of a connected pipeline where delegates are created.
+ */
+template<class... Ret, class S, class R>
+class token_operation<token<Ret...>, S, R>
+{
+    using this_t = token_operation<token<Ret...>, S, R>;
+
+    S sender_;
+    R receiver_;
+
+    void error_handler(error_code e) { receiver_.error(e); }
+    void cancel_handler() { receiver_.cancelled(); }
+    void done_handler(Ret... v) { receiver_.done(std::move(v)...); }
+
+  public:
+    token_operation(S&& s, R&& r)
+        : sender_(std::forward<S>(s)), receiver_(std::forward<R>(r))
+    {
+    }
+
+    token_operation(const token_operation&) = delete;
+    token_operation& operator=(const token_operation&) = delete;
+
+    void start()
+    {
+        sender_.submit(token<Ret...>{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            SA::delegate<void(Ret...)>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    void cancel() { sender_.cancel(); }
+};
+} // namespace detail
+
+#ifndef LIBSTREAM_TRACE
+template<class S, class R> concept bool Connectable = requires(S&& s, R&& r)
+{
+    std::forward<S>(s).connect(std::forward<R>(r));
+};
+#else
+// Traced contexts keep their tokens, so that every hop is recorded.
+template<class S, class R> concept bool Connectable = false;
+#endif
+
+/*!
+ * Connects a sender to a receiver, which provides done(), error() and
+ * cancelled() like a token. The returned operation is started with start()
+ * and cancelled with cancel(), it must not be moved.
+ *
+ * Contexts which support it are connected to a receiver pointing back to the
+ * operation of the stage above, so completions are direct calls and only the
+ * lowest sender is handed a token. Other senders are connected through a
+ * token.
+ */
+template<class S, class R> auto connect(S&& s, R&& r)
+{
+    using token_t =
+        typename detail::token_for<decltype(std::declval<S&>().submit())>::type;
+    return detail::token_operation<token_t, S, R>{std::forward<S>(s),
+                                                  std::forward<R>(r)};
+}
+
+template<class S, class R> requires Connectable<S, R> auto connect(S&& s, R&& r)
+{
+    return std::forward<S>(s).connect(std::forward<R>(r));
+}
+
+template<class S, class R>
+using connect_result_t =
+    decltype(connect(std::declval<S>(), std::declval<R>()));
+
+} // namespace stream
+
+#endif // LIBSTREAM_CONNECT_HPP_
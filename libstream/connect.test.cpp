@@ -0,0 +1,131 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/action.hpp>
+#include <libstream/connect.hpp>
+#include <libstream/filter.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/action.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+SCENARIO("Connecting a read pipeline.")
+{
+    read_mock reader;
+    auto      s = reader | transform_read([](int v) { return v + 1; }) |
+               filter_read([](int v) { return v % 2 == 0; }) |
+               transform_read([](int v) { return v * 10; });
+
+    REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+
+    read_callback_mock   done_mock;
+    error_callback_mock  error_mock;
+    cancel_callback_mock cancel_mock;
+    auto op = connect(s.read(), read_token<int>{error_mock, cancel_mock,
+                                                 done_mock});
+
+    WHEN("It is started.")
+    {
+        read_token<int> t;
+        REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .LR_SIDE_EFFECT(t = _1);
+        op.start();
+
+        THEN("An accepted value completes all stages.")
+        {
+            REQUIRE_CALL(done_mock, call(20));
+            t.done(1);
+        }
+
+        THEN("A rejected value restarts only the lowest sender.")
+        {
+            REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            t.done(2);
+
+            REQUIRE_CALL(done_mock, call(40));
+            t.done(3);
+        }
+
+        THEN("Errors are forwarded.")
+        {
+            REQUIRE_CALL(error_mock, call(dummy_error));
+            t.error(dummy_error);
+        }
+
+        THEN("Cancellations are forwarded.")
+        {
+            REQUIRE_CALL(reader.sender_, cancel());
+            op.cancel();
+            REQUIRE_CALL(cancel_mock, call());
+            t.cancelled();
+        }
+    }
+}
+
+SCENARIO("Connecting an action.")
+{
+    write_mock  writer;
+    action_mock closure;
+    auto        s = action(writer, closure);
+
+    REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+    REQUIRE_CALL(closure, call()).LR_RETURN(closure.sender_);
+
+    done_callback_mock   done_mock;
+    error_callback_mock  error_mock;
+    cancel_callback_mock cancel_mock;
+    auto op =
+        connect(s.write(2), base_token{error_mock, cancel_mock, done_mock});
+
+    token<> closure_token;
+    REQUIRE_CALL(closure.sender_, submit(ANY(token<>)))
+        .LR_SIDE_EFFECT(closure_token = _1);
+    op.start();
+
+    WHEN("The action completes.")
+    {
+        base_token writer_token;
+        REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+            .LR_SIDE_EFFECT(writer_token = _1);
+        closure_token.done();
+
+        THEN("The write completes to the receiver.")
+        {
+            REQUIRE_CALL(done_mock, call());
+            writer_token.done();
+        }
+
+        THEN("The write is cancelled.")
+        {
+            REQUIRE_CALL(writer.sender_, cancel());
+            op.cancel();
+        }
+    }
+
+    WHEN("The action fails.")
+    {
+        REQUIRE_CALL(error_mock, call(dummy_error));
+        closure_token.error(dummy_error);
+    }
+
+    WHEN("The action is cancelled.")
+    {
+        REQUIRE_CALL(closure.sender_, cancel());
+        op.cancel();
+    }
+}
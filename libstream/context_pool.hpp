@@ -0,0 +1,284 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_CONTEXT_POOL_HPP_
+#define LIBSTREAM_CONTEXT_POOL_HPP_
+
+#include <libstream/callback.hpp>
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+/*!
+ * Fixed number of slots which own senders while their asynchronous operation
+ * is in flight.
+ *
+ * submit() moves the sender into a free slot and submits it. The slot is
+ * released before the completion callback of the caller is invoked, so the
+ * callback can submit the next operation into it. The sender itself is only
+ * destroyed once the callback returned:
+ *
+ * - Operations completing inline are destroyed once the outermost submit()
+ *   returns, then their callbacks are invoked. The stack does not grow with
+ *   inline completions.
+ * - An operation completing asynchronously is moved to one spare storage
+ *   while its callback runs, so the slot can be reused immediately.
+ *
+ * If all slots are in use the error callback is invoked with ENOBUFS. The pool
+ * is not thread-safe and has to outlive all operations submitted to it.
+ */
+template<std::size_t N, std::size_t Size = 128> class context_pool
+{
+  public:
+    using handle                           = std::size_t;
+    static constexpr handle invalid_handle = N;
+
+  private:
+    using storage_t = std::aligned_storage_t<Size>;
+
+    struct slot
+    {
+        storage_t* storage_;
+        void*      operation_;
+        void (*cancel_)(void*);
+        void (*complete_)(void*, bool);
+        void (*destroy_)(void*);
+        handle next_;
+    };
+
+    template<class Sender, class Token> class operation;
+
+    template<class Sender, class... Ret>
+    class operation<Sender, token<Ret...>>
+    {
+        using this_t = operation<Sender, token<Ret...>>;
+
+        context_pool&                     pool_;
+        handle                            handle_;
+        Sender                            sender_;
+        token<Ret...>                     token_;
+        std::optional<std::tuple<Ret...>> value_;
+        error_code                        error_     = 0;
+        bool                              cancelled_ = false;
+
+        void error(error_code e)
+        {
+            error_ = e;
+            pool_.retire(handle_);
+        }
+        void cancelled()
+        {
+            cancelled_ = true;
+            pool_.retire(handle_);
+        }
+        void done(Ret... v)
+        {
+            value_.emplace(v...);
+            pool_.retire(handle_);
+        }
+
+      public:
+        operation(context_pool& p, handle h, Sender&& s, token<Ret...>&& t)
+            : pool_(p), handle_(h), sender_(std::forward<Sender>(s)),
+              token_(std::move(t))
+        {
+        }
+
+        void start()
+        {
+            sender_.submit(token<Ret...>{
+                error_token::template create<this_t, &this_t::error>(this),
+                cancel_token::template create<this_t, &this_t::cancelled>(
+                    this),
+                SA::delegate<void(Ret...)>::template create<this_t,
+                                                            &this_t::done>(
+                    this)});
+        }
+
+        static void cancel(void* self)
+        {
+            static_cast<this_t*>(self)->sender_.cancel();
+        }
+
+        /*
+         * Invokes the token with the stored result. If release is set the
+         * operation is destroyed and its slot freed before.
+         */
+        static void complete(void* self, bool release)
+        {
+            auto& op        = *static_cast<this_t*>(self);
+            auto  t         = std::move(op.token_);
+            auto  value     = std::move(op.value_);
+            auto  e         = op.error_;
+            bool  cancelled = op.cancelled_;
+            if(release)
+            {
+                auto& pool = op.pool_;
+                auto  h    = op.handle_;
+                op.~operation();
+                pool.release(h);
+            }
+
+            if(value) { std::apply(t.done, *value); }
+            else if(cancelled)
+            {
+                t.cancelled();
+            }
+            else
+            {
+                t.error(e);
+            }
+        }
+
+        static void destroy(void* self)
+        {
+            static_cast<this_t*>(self)->~operation();
+        }
+    };
+
+    std::array<storage_t, N + 1> storage_;
+    std::array<slot, N>          slots_;
+    std::array<bool, N>          in_use_{};
+    storage_t*                   spare_      = &storage_[N];
+    handle                       free_       = 0;
+    handle                       completed_  = invalid_handle;
+    handle                       last_       = invalid_handle;
+    std::size_t                  depth_      = 0;
+    std::size_t                  size_       = 0;
+    std::size_t                  high_water_ = 0;
+
+    void release(handle h)
+    {
+        slots_[h].next_ = free_;
+        free_           = h;
+        --size_;
+    }
+
+    /*
+     * Called from the completion of the operation in slot h. Inside of submit()
+     * the operation is queued. Otherwise the slot gets the spare storage and
+     * is released, and the operation is destroyed after its callback returned.
+     * Only one such callback runs at a time, all completions inside of it are
+     * queued.
+     */
+    void retire(handle h)
+    {
+        in_use_[h]      = false;
+        slots_[h].next_ = invalid_handle;
+        if(depth_ > 0)
+        {
+            if(last_ == invalid_handle) { completed_ = h; }
+            else
+            {
+                slots_[last_].next_ = h;
+            }
+            last_ = h;
+            return;
+        }
+
+        auto* op           = slots_[h].operation_;
+        auto  complete     = slots_[h].complete_;
+        auto  destroy      = slots_[h].destroy_;
+        auto* storage      = slots_[h].storage_;
+        slots_[h].storage_ = spare_;
+        spare_             = storage;
+        release(h);
+
+        ++depth_;
+        complete(op, false);
+        destroy(op);
+        leave();
+    }
+
+    /*
+     * Leaves a frame of the pool. The outermost frame destroys the operations
+     * which completed inline and invokes their callbacks.
+     */
+    void leave()
+    {
+        if(depth_ > 1)
+        {
+            --depth_;
+            return;
+        }
+        while(completed_ != invalid_handle)
+        {
+            handle h   = completed_;
+            completed_ = slots_[h].next_;
+            if(completed_ == invalid_handle) { last_ = invalid_handle; }
+            slots_[h].complete_(slots_[h].operation_, true);
+        }
+        depth_ = 0;
+    }
+
+  public:
+    context_pool()
+    {
+        for(handle h = 0; h < N; ++h)
+        {
+            slots_[h].storage_ = &storage_[h];
+            slots_[h].next_    = h + 1;
+        }
+    }
+
+    context_pool(const context_pool&) = delete;
+    context_pool& operator=(const context_pool&) = delete;
+
+    template<class Sender, class... Ret>
+    handle submit(Sender&& s, token<Ret...> t)
+    {
+        using op_t = operation<Sender, token<Ret...>>;
+        static_assert(sizeof(op_t) <= Size,
+                      "The operation does not fit into a pool slot.");
+        static_assert(alignof(op_t) <= alignof(storage_t),
+                      "The operation is overaligned for a pool slot.");
+
+        if(free_ == invalid_handle)
+        {
+            t.error(static_cast<error_code>(std::errc::no_buffer_space));
+            return invalid_handle;
+        }
+
+        handle h = free_;
+        free_    = slots_[h].next_;
+        ++size_;
+        if(size_ > high_water_) { high_water_ = size_; }
+        in_use_[h] = true;
+
+        auto* op = new(slots_[h].storage_)
+            op_t{*this, h, std::forward<Sender>(s), std::move(t)};
+        slots_[h].operation_ = op;
+        slots_[h].cancel_    = &op_t::cancel;
+        slots_[h].complete_  = &op_t::complete;
+        slots_[h].destroy_   = &op_t::destroy;
+        ++depth_;
+        op->start();
+        leave();
+        return h;
+    }
+
+    void cancel(handle h)
+    {
+        if(h < N && in_use_[h]) { slots_[h].cancel_(slots_[h].operation_); }
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    std::size_t high_water_mark() const noexcept { return high_water_; }
+    static constexpr std::size_t capacity() noexcept { return N; }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_CONTEXT_POOL_HPP_
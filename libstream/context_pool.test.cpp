@@ -0,0 +1,246 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/context_pool.hpp>
+
+#include <libstream/filter.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <memory>
+#include <system_error>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+/*
+ * Completes inline and touches its own heap state afterwards, like the
+ * trampoline of an adaptor does.
+ */
+struct inline_counter
+{
+    struct sender
+    {
+        int&                 next_;
+        std::unique_ptr<int> submitted_ = std::make_unique<int>(0);
+
+        int  submit() { return next_++; }
+        void submit(read_token<int>&& t)
+        {
+            t.done(next_++);
+            ++*submitted_;
+        }
+        void cancel() {}
+    };
+
+    int next_ = 0;
+
+    sender read() { return sender{next_}; }
+};
+} // namespace
+
+SCENARIO("Pooled operations.")
+{
+    GIVEN("A pool with two slots and a read stream that adds one.")
+    {
+        context_pool<2> pool;
+        read_mock       reader;
+        auto s = stream::transform_read(reader, [](int v) { return v + 1; });
+
+        read_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_token<int> user_token{error_mock, cancel_mock, callback_mock};
+
+        REQUIRE(pool.size() == 0);
+        REQUIRE(pool.high_water_mark() == 0);
+
+        WHEN("An operation is submitted.")
+        {
+            read_token<int> t;
+            REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+            REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            auto h = pool.submit(s.read(), user_token);
+
+            THEN("It occupies a slot.")
+            {
+                REQUIRE(h != pool.invalid_handle);
+                REQUIRE(pool.size() == 1);
+                REQUIRE(pool.high_water_mark() == 1);
+            }
+
+            WHEN("The operation completes.")
+            {
+                REQUIRE_CALL(callback_mock, call(2));
+                t.done(1);
+
+                THEN("The slot is recycled.")
+                {
+                    REQUIRE(pool.size() == 0);
+                    REQUIRE(pool.high_water_mark() == 1);
+                }
+            }
+
+            WHEN("The operation fails.")
+            {
+                REQUIRE_CALL(error_mock, call(dummy_error));
+                t.error(dummy_error);
+                REQUIRE(pool.size() == 0);
+            }
+
+            WHEN("The operation is cancelled.")
+            {
+                REQUIRE_CALL(reader.sender_, cancel());
+                pool.cancel(h);
+
+                REQUIRE_CALL(cancel_mock, call());
+                t.cancelled();
+                REQUIRE(pool.size() == 0);
+            }
+        }
+
+        WHEN("More operations are submitted than slots are available.")
+        {
+            write_mock writer;
+            base_token t[2];
+            REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_).TIMES(3);
+            REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t[0] = _1);
+            REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t[1] = _1);
+
+            done_callback_mock   done_mock;
+            error_callback_mock  write_error_mock;
+            cancel_callback_mock write_cancel_mock;
+            base_token write_token{write_error_mock, write_cancel_mock,
+                                   done_mock};
+
+            pool.submit(writer.write(1), write_token);
+            pool.submit(writer.write(1), write_token);
+
+            THEN("The excess operation fails without being submitted.")
+            {
+                REQUIRE_CALL(write_error_mock,
+                             call(static_cast<error_code>(
+                                 std::errc::no_buffer_space)));
+                REQUIRE(pool.submit(writer.write(1), write_token) ==
+                        pool.invalid_handle);
+                REQUIRE(pool.size() == 2);
+                REQUIRE(pool.high_water_mark() == 2);
+            }
+
+            WHEN("One operation completes.")
+            {
+                REQUIRE_CALL(done_mock, call());
+                t[1].done();
+
+                THEN("Its slot can be reused.")
+                {
+                    REQUIRE_CALL(writer.sender_, submit(ANY(base_token)));
+                    REQUIRE(pool.submit(writer.write(1), write_token) !=
+                            pool.invalid_handle);
+                    REQUIRE(pool.high_water_mark() == 2);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Pooled operations which complete inline.")
+{
+    GIVEN("A pool with one slot and a filtered stream completing inline.")
+    {
+        context_pool<1, 256> pool;
+        inline_counter       counter;
+        auto s = stream::filter_read(counter, [](int v) { return v % 2 == 0; });
+
+        read_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_token<int> user_token{error_mock, cancel_mock, callback_mock};
+
+        WHEN("The callback submits the next operation.")
+        {
+            vector<int>                    depths;
+            vector<decltype(pool)::handle> handles;
+            int                            depth = 0;
+            auto                           submit = [&] {
+                ++depth;
+                handles.push_back(pool.submit(s.read(), user_token));
+                --depth;
+            };
+            REQUIRE_CALL(callback_mock, call(_))
+                .TIMES(3)
+                .LR_SIDE_EFFECT(depths.push_back(depth))
+                .LR_SIDE_EFFECT(if(_1 < 4) { submit(); });
+            submit();
+
+            THEN("The operations reuse the slot without nesting.")
+            {
+                REQUIRE(handles == vector<decltype(pool)::handle>{0, 0, 0});
+                REQUIRE(depths == vector<int>{1, 1, 1});
+                REQUIRE(pool.size() == 0);
+                REQUIRE(pool.high_water_mark() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Pooled operations which complete asynchronously.")
+{
+    GIVEN("A pool with one slot and a read stream.")
+    {
+        context_pool<1> pool;
+        read_mock       reader;
+
+        read_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_token<int> user_token{error_mock, cancel_mock, callback_mock};
+
+        WHEN("Every callback submits the next operation.")
+        {
+            read_token<int>                t;
+            vector<decltype(pool)::handle> handles;
+            ALLOW_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            REQUIRE_CALL(callback_mock, call(_))
+                .TIMES(5)
+                .LR_SIDE_EFFECT(if(_1 < 4) {
+                    handles.push_back(pool.submit(reader.sender_, user_token));
+                });
+            handles.push_back(pool.submit(reader.sender_, user_token));
+
+            for(int i = 0; i < 5; ++i)
+            {
+                REQUIRE(pool.size() == 1);
+                auto current = t;
+                current.done(i);
+            }
+
+            THEN("The slot is reused for every operation.")
+            {
+                REQUIRE(handles ==
+                        vector<decltype(pool)::handle>{0, 0, 0, 0, 0});
+                REQUIRE(pool.size() == 0);
+                REQUIRE(pool.high_water_mark() == 1);
+            }
+        }
+    }
+}
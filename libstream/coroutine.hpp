@@ -0,0 +1,313 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_COROUTINE_HPP_
+#define LIBSTREAM_COROUTINE_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/connect.hpp>
+
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+#elif __has_include(<experimental/coroutine>)
+#include <experimental/coroutine>
+#else
+#error "libstream/coroutine.hpp requires compiler support for coroutines."
+#endif
+
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+namespace coro = std;
+#else
+namespace coro = std::experimental;
+#endif
+
+template<class S> concept bool Sender = requires(S& s)
+{
+    s.submit();
+    s.cancel();
+};
+
+/*!
+ * Outcome of an awaited operation. Exactly one of value, error or
+ * cancellation is set.
+ */
+template<class T = void> class await_result
+{
+    std::optional<T> value_;
+    error_code       error_     = 0;
+    bool             cancelled_ = false;
+
+  public:
+    void set_value(T v) { value_.emplace(std::move(v)); }
+    void set_error(error_code e) { error_ = e; }
+    void set_cancelled() { cancelled_ = true; }
+
+    explicit operator bool() const noexcept { return value_.has_value(); }
+    T&       value() & { return *value_; }
+    const T& value() const& { return *value_; }
+    T&&      value() && { return std::move(*value_); }
+    error_code error() const noexcept { return error_; }
+    bool       cancelled() const noexcept { return cancelled_; }
+};
+
+template<> class await_result<void>
+{
+    bool       done_      = false;
+    error_code error_     = 0;
+    bool       cancelled_ = false;
+
+  public:
+    void set_value() { done_ = true; }
+    void set_error(error_code e) { error_ = e; }
+    void set_cancelled() { cancelled_ = true; }
+
+    explicit operator bool() const noexcept { return done_; }
+    error_code error() const noexcept { return error_; }
+    bool       cancelled() const noexcept { return cancelled_; }
+};
+
+namespace detail
+{
+template<class S, class T, class... Ret> class basic_sender_awaiter
+{
+    using this_t = basic_sender_awaiter<S, T, Ret...>;
+
+    S                        sender_;
+    await_result<T>          result_;
+    coro::coroutine_handle<> continuation_;
+    std::atomic<bool>        settled_{false};
+
+    /*
+     * Both the completion and await_suspend() try to settle the operation.
+     * Whoever comes second owns the continuation: await_suspend() resumes
+     * inline by returning false, a completion resumes the coroutine itself.
+     */
+    void complete()
+    {
+        if(settled_.exchange(true, std::memory_order_acq_rel))
+        {
+            continuation_.resume();
+        }
+    }
+
+    void error(error_code e)
+    {
+        result_.set_error(e);
+        complete();
+    }
+
+    void cancelled()
+    {
+        result_.set_cancelled();
+        complete();
+    }
+
+    void done(Ret... v)
+    {
+        result_.set_value(std::move(v)...);
+        complete();
+    }
+
+  public:
+    basic_sender_awaiter(S&& s) : sender_(std::forward<S>(s)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(coro::coroutine_handle<> h)
+    {
+        continuation_ = h;
+        sender_.submit(token<Ret...>{
+            error_token::template create<this_t, &this_t::error>(this),
+            cancel_token::template create<this_t, &this_t::cancelled>(this),
+            SA::delegate<void(Ret...)>::template create<this_t,
+                                                        &this_t::done>(
+                this)});
+        return !settled_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    await_result<T> await_resume() { return std::move(result_); }
+};
+
+template<class S, class T = decltype(std::declval<S&>().submit())>
+struct sender_awaiter : basic_sender_awaiter<S, T, T>
+{
+    using basic_sender_awaiter<S, T, T>::basic_sender_awaiter;
+};
+
+template<class S>
+struct sender_awaiter<S, void> : basic_sender_awaiter<S, void>
+{
+    using basic_sender_awaiter<S, void>::basic_sender_awaiter;
+};
+
+/*!
+ * Found by argument dependent lookup for all contexts of this library.
+ */
+template<Sender S> auto operator co_await(S&& s)
+{
+    return sender_awaiter<S>{std::forward<S>(s)};
+}
+} // namespace detail
+
+using detail::operator co_await;
+
+/*!
+ * Makes a sender from another namespace awaitable.
+ */
+template<Sender S> auto awaitable(S&& s)
+{
+    return detail::sender_awaiter<S>{std::forward<S>(s)};
+}
+
+template<class T = void> class task;
+
+namespace detail
+{
+template<class T> class task_promise_base
+{
+    coro::coroutine_handle<> continuation_;
+
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template<class Promise>
+        coro::coroutine_handle<>
+        await_suspend(coro::coroutine_handle<Promise> h) noexcept
+        {
+            auto& p = h.promise();
+            if(p.continuation_) { return p.continuation_; }
+            if(p.token_) { p.report(); }
+            return coro::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+  protected:
+    std::optional<typename token_for<T>::type> token_;
+
+  public:
+    coro::suspend_always initial_suspend() const noexcept { return {}; }
+    final_awaiter        final_suspend() const noexcept { return {}; }
+    void                 unhandled_exception() const noexcept
+    {
+        std::terminate();
+    }
+
+    void set_continuation(coro::coroutine_handle<> h) { continuation_ = h; }
+    void set_token(typename token_for<T>::type&& t)
+    {
+        token_.emplace(std::move(t));
+    }
+};
+
+template<class T> class task_promise : public task_promise_base<T>
+{
+    std::optional<T> value_;
+
+  public:
+    task<T> get_return_object();
+    void    return_value(T v) { value_.emplace(std::move(v)); }
+    void    report() { this->token_->done(*value_); }
+    T       result() { return std::move(*value_); }
+};
+
+template<> class task_promise<void> : public task_promise_base<void>
+{
+  public:
+    task<void> get_return_object();
+    void       return_void() const noexcept {}
+    void       report() { this->token_->done(); }
+    void       result() const noexcept {}
+};
+} // namespace detail
+
+/*!
+ * Lazily started coroutine.
+ *
+ * Awaiting a task starts it and resumes the awaiting coroutine through
+ * symmetric transfer once the task has finished, so arbitrarily long chains
+ * of tasks complete with constant stack depth. A task that is not awaited is
+ * started by submit(), which reports its result to the token.
+ */
+template<class T> class task
+{
+  public:
+    using promise_type = detail::task_promise<T>;
+
+  private:
+    using handle_t = coro::coroutine_handle<promise_type>;
+    handle_t handle_;
+
+    struct awaiter
+    {
+        handle_t handle_;
+
+        bool await_ready() const noexcept { return false; }
+
+        coro::coroutine_handle<> await_suspend(coro::coroutine_handle<> h)
+        {
+            handle_.promise().set_continuation(h);
+            return handle_;
+        }
+
+        decltype(auto) await_resume() { return handle_.promise().result(); }
+    };
+
+  public:
+    explicit task(handle_t h) : handle_(h) {}
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    task& operator=(task&& other) noexcept
+    {
+        if(this != &other)
+        {
+            if(handle_) { handle_.destroy(); }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~task()
+    {
+        if(handle_) { handle_.destroy(); }
+    }
+
+    awaiter operator co_await() && noexcept { return awaiter{handle_}; }
+
+    void submit(typename detail::token_for<T>::type&& t)
+    {
+        handle_.promise().set_token(std::move(t));
+        handle_.resume();
+    }
+
+    bool done() const noexcept { return handle_.done(); }
+};
+
+namespace detail
+{
+template<class T> task<T> task_promise<T>::get_return_object()
+{
+    return task<T>{coro::coroutine_handle<task_promise<T>>::from_promise(*this)};
+}
+
+inline task<void> task_promise<void>::get_return_object()
+{
+    return task<void>{
+        coro::coroutine_handle<task_promise<void>>::from_promise(*this)};
+}
+} // namespace detail
+} // namespace stream
+
+#endif // LIBSTREAM_COROUTINE_HPP_
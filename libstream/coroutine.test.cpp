@@ -0,0 +1,222 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/coroutine.hpp>
+
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+struct inline_reader
+{
+    struct sender
+    {
+        int  submit() { return 1; }
+        void submit(read_token<int>&& t) { t.done(1); }
+        void cancel() {}
+    };
+
+    sender read() const { return sender{}; }
+};
+
+template<class S> task<int> read_value(S& s)
+{
+    auto r = co_await s.read();
+    if(r) { co_return r.value(); }
+    co_return r.cancelled() ? -1 : -r.error();
+}
+
+task<int> read_twice(read_mock& reader)
+{
+    int a = co_await read_value(reader);
+    int b = co_await read_value(reader);
+    co_return a + b;
+}
+
+task<error_code> write_value(write_mock& writer, int v)
+{
+    auto r = co_await writer.write(v);
+    co_return r.error();
+}
+
+task<int> one() { co_return 1; }
+
+task<> write_twice(write_mock& writer)
+{
+    co_await writer.write(1);
+    co_await writer.write(2);
+}
+
+task<int> count_up(int n)
+{
+    int sum = 0;
+    for(int i = 0; i < n; ++i) { sum += co_await one(); }
+    co_return sum;
+}
+
+task<int> sum_inline(const inline_reader& reader, int n)
+{
+    int sum = 0;
+    for(int i = 0; i < n; ++i) { sum += (co_await reader.read()).value(); }
+    co_return sum;
+}
+} // namespace
+
+SCENARIO("Awaiting read senders.")
+{
+    read_callback_mock   callback_mock;
+    error_callback_mock  error_mock;
+    cancel_callback_mock cancel_mock;
+
+    GIVEN("A read stream that adds one.")
+    {
+        read_mock reader;
+        auto s = stream::transform_read(reader, [](int v) { return v + 1; });
+
+        read_token<int> t;
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .LR_SIDE_EFFECT(t = _1);
+
+        auto c = read_value(s);
+        c.submit(read_token<int>{error_mock, cancel_mock, callback_mock});
+        REQUIRE(!c.done());
+
+        WHEN("The value is read.")
+        {
+            REQUIRE_CALL(callback_mock, call(3));
+            t.done(2);
+            REQUIRE(c.done());
+        }
+
+        WHEN("The read fails.")
+        {
+            REQUIRE_CALL(callback_mock, call(-dummy_error));
+            t.error(dummy_error);
+        }
+
+        WHEN("The read is cancelled.")
+        {
+            REQUIRE_CALL(callback_mock, call(-1));
+            t.cancelled();
+        }
+    }
+
+    GIVEN("A read stream which completes inline.")
+    {
+        read_mock reader;
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_).TIMES(2);
+        REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .SIDE_EFFECT(_1.done(4))
+            .TIMES(2);
+
+        THEN("The coroutine continues without suspending.")
+        {
+            auto c = read_twice(reader);
+            REQUIRE_CALL(callback_mock, call(8));
+            c.submit(read_token<int>{error_mock, cancel_mock, callback_mock});
+            REQUIRE(c.done());
+        }
+    }
+
+    GIVEN("A read stream which always completes inline.")
+    {
+        inline_reader reader;
+
+        THEN("Many reads do not grow the stack.")
+        {
+            auto c = sum_inline(reader, 1000000);
+            REQUIRE_CALL(callback_mock, call(1000000));
+            c.submit(read_token<int>{error_mock, cancel_mock, callback_mock});
+        }
+    }
+}
+
+SCENARIO("Awaiting write senders.")
+{
+    GIVEN("A write stream.")
+    {
+        write_mock writer;
+        base_token t;
+        REQUIRE_CALL(writer, write(5)).LR_RETURN(writer.sender_);
+        REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+            .LR_SIDE_EFFECT(t = _1);
+
+        read_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        auto c = write_value(writer, 5);
+        c.submit(read_token<int>{error_mock, cancel_mock, callback_mock});
+
+        WHEN("The write completes.")
+        {
+            REQUIRE_CALL(callback_mock, call(0));
+            t.done();
+        }
+
+        WHEN("The write fails.")
+        {
+            REQUIRE_CALL(callback_mock, call(dummy_error));
+            t.error(dummy_error);
+        }
+    }
+}
+
+SCENARIO("Chained tasks.")
+{
+    GIVEN("A task awaiting many other tasks.")
+    {
+        read_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        THEN("All results are collected.")
+        {
+            auto c = count_up(10000);
+            REQUIRE_CALL(callback_mock, call(10000));
+            c.submit(read_token<int>{error_mock, cancel_mock, callback_mock});
+        }
+    }
+}
+
+SCENARIO("Tasks without a result.")
+{
+    GIVEN("A task which writes twice.")
+    {
+        write_mock writer;
+        REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_);
+        REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+        REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+            .TIMES(2)
+            .SIDE_EFFECT(_1.done());
+
+        done_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        THEN("It is submitted with a base token.")
+        {
+            auto c = write_twice(writer);
+            REQUIRE_CALL(callback_mock, call());
+            c.submit(base_token{error_mock, cancel_mock, callback_mock});
+            REQUIRE(c.done());
+        }
+    }
+}
@@ -10,88 +10,260 @@
 
 #include <libstream/callback.hpp>
 #include <libstream/concepts/stream.hpp>
+#include <libstream/detail/tuple.hpp>
+#include <libstream/trace.hpp>
 
 #include <experimental/ranges/range>
 
+#include <bitset>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace stream
 {
+/*!
+ * Submits the children one after the other, each write starts when the
+ * previous one completed.
+ */
+struct sequential_t
+{
+};
+inline constexpr sequential_t sequential{};
+
+/*!
+ * Submits all children at once and completes when all of them finished. The
+ * first error is reported and cancels the children which are still running.
+ */
+struct concurrent_t
+{
+};
+inline constexpr concurrent_t concurrent{};
+
+template<class P>
+concept bool DemultiplexPolicy =
+    std::is_same_v<P, sequential_t> || std::is_same_v<P, concurrent_t>;
+
 namespace detail
 {
-template<class C1, class C2> class write_context
+template<class... C> class write_context
 {
-    C1         child1_;
-    C2         child2_;
-    base_token done_token_;
-    bool       first_child_;
+    static constexpr std::size_t size = sizeof...(C);
+
+    std::tuple<C...> children_;
+    base_token       done_token_;
+    std::size_t      current_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    void submit_current()
+    {
+        using this_t = write_context<C...>;
+        visit_at(children_, current_,
+                 [this](auto& child) {
+                     if(current_ + 1 == size)
+                     { child.submit(std::move(done_token_)); }
+                     else
+                     {
+                         child.submit(base_token{
+                             done_token_.error, done_token_.cancelled,
+                             done_token::template create<
+                                 this_t, &this_t::done_handler>(this)});
+                     }
+                 },
+                 std::index_sequence_for<C...>{});
+    }
 
     void done_handler()
     {
-        first_child_ = false;
-        child2_.submit(std::move(done_token_));
+        ++current_;
+        submit_current();
     }
 
   public:
-    write_context(C1 c1, C2 c2) : child1_(c1), child2_(c2) {}
+    write_context(C&&... c) : children_(std::forward<C>(c)...) {}
 
     void submit()
     {
-        child1_.submit();
-        child2_.submit();
+        LIBSTREAM_TRACE_SYNC("demultiplex_write")
+        std::apply([](auto&... child) { (child.submit(), ...); }, children_);
     }
 
     void submit(base_token t)
     {
-        done_token_  = std::move(t);
-        first_child_ = true;
-        using this_t = write_context<C1, C2>;
-        child1_.submit(base_token{
-            t.error, t.cancelled,
-            done_token::template create<this_t, &this_t::done_handler>(this)});
+        done_token_ =
+            LIBSTREAM_TRACE_WRAP("demultiplex_write", std::move(t));
+        current_    = 0;
+        submit_current();
     }
 
     void cancel()
     {
-        if(first_child_) { child1_.cancel(); }
+        visit_at(children_, current_, [](auto& child) { child.cancel(); },
+                 std::index_sequence_for<C...>{});
+    }
+};
+
+template<class... C> write_context(C&&...)->write_context<C...>;
+
+template<class... C> class concurrent_write_context
+{
+    static constexpr std::size_t size = sizeof...(C);
+
+    std::tuple<C...>  children_;
+    base_token        token_;
+    std::bitset<size> running_;
+    std::size_t       remaining_;
+    error_code        error_;
+    bool              failed_;
+    bool              cancelled_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    template<std::size_t I> void submit_child()
+    {
+        if(failed_)
+        {
+            finish_child();
+            return;
+        }
+
+        using this_t = concurrent_write_context<C...>;
+        running_.set(I);
+        std::get<I>(children_).submit(base_token{
+            error_token::template create<this_t,
+                                         &this_t::template error_handler<I>>(
+                this),
+            cancel_token::template create<this_t,
+                                          &this_t::template cancel_handler<I>>(
+                this),
+            done_token::template create<this_t,
+                                        &this_t::template done_handler<I>>(
+                this)});
+    }
+
+    template<std::size_t... I> void submit_all(std::index_sequence<I...>)
+    {
+        (submit_child<I>(), ...);
+    }
+
+    template<std::size_t... I> void cancel_running(std::index_sequence<I...>)
+    {
+        ((running_.test(I) ? std::get<I>(children_).cancel() : void()), ...);
+    }
+
+    void finish_child()
+    {
+        if(--remaining_ != 0) { return; }
+
+        if(failed_) { token_.error(error_); }
+        else if(cancelled_)
+        {
+            token_.cancelled();
+        }
         else
         {
-            child2_.cancel();
+            token_.done();
+        }
+    }
+
+    template<std::size_t I> void done_handler()
+    {
+        running_.reset(I);
+        finish_child();
+    }
+
+    template<std::size_t I> void error_handler(error_code e)
+    {
+        running_.reset(I);
+        if(!failed_)
+        {
+            failed_ = true;
+            error_  = e;
+            cancel_running(std::index_sequence_for<C...>{});
         }
+        finish_child();
     }
+
+    template<std::size_t I> void cancel_handler()
+    {
+        running_.reset(I);
+        cancelled_ = true;
+        finish_child();
+    }
+
+  public:
+    concurrent_write_context(C&&... c) : children_(std::forward<C>(c)...) {}
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("demultiplex_write")
+        std::apply([](auto&... child) { (child.submit(), ...); }, children_);
+    }
+
+    void submit(base_token t)
+    {
+        token_     = LIBSTREAM_TRACE_WRAP("demultiplex_write", std::move(t));
+        remaining_ = size;
+        failed_    = false;
+        cancelled_ = false;
+        running_.reset();
+        submit_all(std::index_sequence_for<C...>{});
+    }
+
+    void cancel() { cancel_running(std::index_sequence_for<C...>{}); }
 };
 
-template<class C1, class C2> write_context(C1&&, C2 &&)->write_context<C1, C2>;
+template<class... C>
+concurrent_write_context(C&&...)->concurrent_write_context<C...>;
 } // namespace detail
-template<PureWriteStreamable S1, PureWriteStreamable S2> class demultiplex_fn
+
+template<DemultiplexPolicy Policy, PureWriteStreamable... S>
+class demultiplex_fn
 {
-    S1 stream1_;
-    S2 stream2_;
+    static_assert(sizeof...(S) > 0, "At least one stream is required.");
 
-  public:
-    demultiplex_fn(S1&& s1, S2&& s2)
-        : stream1_(std::forward<S1>(s1)), stream2_(std::forward<S2>(s2))
+    std::tuple<S...> streams_;
+
+    template<class... C> static auto make_context(C&&... c)
     {
+        if constexpr(std::is_same_v<Policy, concurrent_t>)
+        { return detail::concurrent_write_context{std::forward<C>(c)...}; }
+        else
+        {
+            return detail::write_context{std::forward<C>(c)...};
+        }
     }
 
+  public:
+    demultiplex_fn(Policy, S&&... s) : streams_(std::forward<S>(s)...) {}
+
     template<class V> auto write(V v) const
     {
-        return detail::write_context{stream1_.write(v), stream2_.write(v)};
+        return std::apply(
+            [&v](auto&... s) { return make_context(s.write(v)...); },
+            streams_);
     }
 
     template<std::experimental::ranges::InputRange R> auto write(R& r) const
     {
-        return detail::write_context{stream1_.write(r), stream2_.write(r)};
+        return std::apply(
+            [&r](auto&... s) { return make_context(s.write(r)...); },
+            streams_);
     }
 };
 
-template<PureWriteStreamable S1, PureWriteStreamable S2>
-demultiplex_fn(S1&&, S2 &&)->demultiplex_fn<S1, S2>;
+template<DemultiplexPolicy Policy, PureWriteStreamable... S>
+demultiplex_fn(Policy, S&&...)->demultiplex_fn<Policy, S...>;
+
+template<PureWriteStreamable... S>
+PureWriteStreamable demultiplex(S&&... s)
+{
+    return demultiplex_fn{sequential, std::forward<S>(s)...};
+}
 
-template<PureWriteStreamable S1, PureWriteStreamable S2>
-PureWriteStreamable demultiplex(S1&& s1, S2&& s2)
+template<DemultiplexPolicy Policy, PureWriteStreamable... S>
+PureWriteStreamable demultiplex(Policy p, S&&... s)
 {
-    return demultiplex_fn{std::forward<S1>(s1), std::forward<S2>(s2)};
+    return demultiplex_fn{p, std::forward<S>(s)...};
 }
 } // namespace stream
 
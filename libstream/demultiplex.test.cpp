@@ -113,6 +113,173 @@ SCENARIO("Sequence writes.")
     }
 }
 
+SCENARIO("Sequence writes to more than two streams.")
+{
+    GIVEN("Three write streams.")
+    {
+        write_mock w[3];
+        auto       s = demultiplex(w[0], w[1], w[2]);
+
+        WHEN("A single value is written.")
+        {
+            REQUIRE_CALL(w[0], write(0)).LR_RETURN(w[0].sender_);
+            REQUIRE_CALL(w[1], write(0)).LR_RETURN(w[1].sender_);
+            REQUIRE_CALL(w[2], write(0)).LR_RETURN(w[2].sender_);
+
+            auto sender = s.write(0);
+            WHEN("Synchronous submit is called.")
+            {
+                REQUIRE_CALL(w[0].sender_, submit());
+                REQUIRE_CALL(w[1].sender_, submit());
+                REQUIRE_CALL(w[2].sender_, submit());
+
+                sender.submit();
+            }
+
+            WHEN("Asynchronous submit is called.")
+            {
+                base_token t;
+                REQUIRE_CALL(w[0].sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t = _1);
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+
+                WHEN("The callbacks are invoked in turn.")
+                {
+                    REQUIRE_CALL(w[1].sender_, submit(ANY(base_token)))
+                        .LR_SIDE_EFFECT(t = _1);
+                    t.done();
+                    REQUIRE_CALL(w[2].sender_, submit(ANY(base_token)))
+                        .LR_SIDE_EFFECT(t = _1);
+                    t.done();
+
+                    REQUIRE_CALL(callback_mock, call());
+                    t.done();
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Concurrent writes.")
+{
+    GIVEN("Three write streams.")
+    {
+        write_mock w[3];
+        auto       s = demultiplex(concurrent, w[0], w[1], w[2]);
+
+        WHEN("A single value is written.")
+        {
+            REQUIRE_CALL(w[0], write(0)).LR_RETURN(w[0].sender_);
+            REQUIRE_CALL(w[1], write(0)).LR_RETURN(w[1].sender_);
+            REQUIRE_CALL(w[2], write(0)).LR_RETURN(w[2].sender_);
+
+            auto sender = s.write(0);
+            WHEN("Synchronous submit is called.")
+            {
+                REQUIRE_CALL(w[0].sender_, submit());
+                REQUIRE_CALL(w[1].sender_, submit());
+                REQUIRE_CALL(w[2].sender_, submit());
+
+                sender.submit();
+            }
+
+            WHEN("Asynchronous submit is called.")
+            {
+                base_token t[3];
+                REQUIRE_CALL(w[0].sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[0] = _1);
+                REQUIRE_CALL(w[1].sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[1] = _1);
+                REQUIRE_CALL(w[2].sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[2] = _1);
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+
+                WHEN("All callbacks are invoked in any order.")
+                {
+                    t[2].done();
+                    t[0].done();
+
+                    REQUIRE_CALL(callback_mock, call());
+                    t[1].done();
+                }
+
+                WHEN("One write fails.")
+                {
+                    constexpr error_code write_error = 5;
+                    t[0].done();
+
+                    REQUIRE_CALL(w[2].sender_, cancel());
+                    t[1].error(write_error);
+
+                    THEN("The error is reported once the others finished.")
+                    {
+                        REQUIRE_CALL(error_mock, call(write_error));
+                        t[2].cancelled();
+                    }
+                }
+
+                WHEN("The operation is cancelled.")
+                {
+                    t[1].done();
+
+                    REQUIRE_CALL(w[0].sender_, cancel());
+                    REQUIRE_CALL(w[2].sender_, cancel());
+                    sender.cancel();
+
+                    t[0].cancelled();
+                    REQUIRE_CALL(cancel_mock, call());
+                    t[2].cancelled();
+                }
+            }
+        }
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(w[0], write_(vector{1, 2}));
+            REQUIRE_CALL(w[1], write_(vector{1, 2}));
+            REQUIRE_CALL(w[2], write_(vector{1, 2}));
+            array a{1, 2};
+
+            auto sender = s.write(a);
+
+            WHEN("Asynchronous submit is called.")
+            {
+                base_token t[3];
+                REQUIRE_CALL(w[0].range_sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[0] = _1);
+                REQUIRE_CALL(w[1].range_sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[1] = _1);
+                REQUIRE_CALL(w[2].range_sender_, submit(ANY(base_token)))
+                    .LR_SIDE_EFFECT(t[2] = _1);
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+
+                t[0].done();
+                t[1].done();
+                REQUIRE_CALL(callback_mock, call());
+                t[2].done();
+            }
+        }
+    }
+}
+
 SCENARIO("Cancellation")
 {
     GIVEN("Two write streams.")
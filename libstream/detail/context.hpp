@@ -9,13 +9,59 @@
 #define LIBSTREAM_DETAIL_CONTEXT_HPP_
 
 #include <libstream/callback.hpp>
+#include <libstream/connect.hpp>
+#include <libstream/trace.hpp>
 
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <utility>
 
 namespace stream
 {
 namespace detail
 {
+/*!
+ * Turns resubmission from within a completion handler into a loop.
+ *
+ * A context that resubmits its child from the child's completion handler
+ * recurses whenever the child completes inline. Routing every submission
+ * through run() unwinds to the outermost call first, so any number of inline
+ * completions is processed with constant stack depth. The action of the
+ * outermost call is repeated, nested calls only request another iteration.
+ */
+class trampoline
+{
+    bool running_ = false;
+    bool pending_ = false;
+
+  public:
+    template<class F> void run(F&& f)
+    {
+        pending_ = true;
+        if(running_) { return; }
+
+        running_ = true;
+        while(pending_)
+        {
+            pending_ = false;
+            f();
+        }
+        running_ = false;
+    }
+
+    /*!
+     * Like run(f), for an f which replaces the sender in child. The outermost
+     * call may come from that sender's own completion handler, so the sender
+     * is kept alive until the handler has returned.
+     */
+    template<class Slot, class F> void run(Slot& child, F&& f)
+    {
+        if(!running_) { child.keep(); }
+        run(std::forward<F>(f));
+    }
+};
+
 struct empty_write_context
 {
     void submit(base_token&& t) { t.done(); }
@@ -26,17 +72,28 @@ struct empty_write_context
 template<class C> struct base_write_context
 {
     C child_context_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
 
     base_write_context(C&& c) : child_context_(c) {}
 
     void submit(base_token&& t)
     {
-        child_context_.submit(std::forward<base_token>(t));
+        child_context_.submit(LIBSTREAM_TRACE_WRAP("write", std::move(t)));
     }
 
-    void submit() { child_context_.submit(); }
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("write")
+        child_context_.submit();
+    }
 
     void cancel() { child_context_.cancel(); }
+
+    template<class R> auto connect(R&& r) &&
+    {
+        return stream::connect(std::forward<C>(child_context_),
+                               std::forward<R>(r));
+    }
 };
 
 template<class C> base_write_context(C &&)->base_write_context<C>;
@@ -44,12 +101,25 @@ template<class C> base_write_context(C &&)->base_write_context<C>;
 template<class C> struct base_range_context
 {
     C child_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
 
-    void submit(base_token&& t) { child_.submit(std::forward<base_token>(t)); }
+    void submit(base_token&& t)
+    {
+        child_.submit(LIBSTREAM_TRACE_WRAP("range", std::move(t)));
+    }
 
-    auto submit() { return child_.submit(); }
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("range")
+        return child_.submit();
+    }
 
     void cancel() { child_.cancel(); }
+
+    template<class R> auto connect(R&& r) &&
+    {
+        return stream::connect(std::forward<C>(child_), std::forward<R>(r));
+    }
 };
 
 template<class C> base_range_context(C&& c)->base_range_context<C>;
@@ -57,15 +127,20 @@ template<class C> base_range_context(C&& c)->base_range_context<C>;
 template<class C> struct base_read_context
 {
     C child_;
+    LIBSTREAM_TRACE_TOKEN(read_token<decltype(std::declval<C>().submit())>)
 
   protected:
     using value_type = decltype(std::declval<C>().submit());
 
-    auto submit() { return child_.submit(); }
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("read")
+        return child_.submit();
+    }
 
     void submit(read_token<value_type>&& t)
     {
-        child_.submit(std::forward<read_token<value_type>>(t));
+        child_.submit(LIBSTREAM_TRACE_WRAP("read", std::move(t)));
     }
 
     void cancel() { child_.cancel(); }
@@ -73,6 +148,56 @@ template<class C> struct base_read_context
 
 template<class C> base_read_context(C&& c)->base_read_context<C>;
 
+/*!
+ * Holds a sender which is replaced for every submission. Senders returned by
+ * reference are owned by the stream and only referenced.
+ *
+ * After keep() the next replacement is constructed next to the current
+ * sender instead of over it, so a sender can be replaced from within its own
+ * completion handler. It is destroyed by a later replacement.
+ */
+template<class C> class sender_slot
+{
+    std::array<std::optional<C>, 2> senders_;
+    std::size_t                     current_ = 0;
+    bool                            keep_    = false;
+
+  public:
+    void emplace(C&& c)
+    {
+        if(keep_)
+        {
+            current_ ^= 1;
+            keep_ = false;
+        }
+        senders_[current_].reset();
+        senders_[current_].emplace(std::move(c));
+    }
+
+    void keep() noexcept { keep_ = true; }
+
+    explicit operator bool() const noexcept
+    {
+        return senders_[current_].has_value();
+    }
+
+    C* operator->() { return &*senders_[current_]; }
+};
+
+template<class C> class sender_slot<C&>
+{
+    C* sender_ = nullptr;
+
+  public:
+    void emplace(C& c) { sender_ = &c; }
+
+    void keep() noexcept {}
+
+    explicit operator bool() const noexcept { return sender_ != nullptr; }
+
+    C* operator->() { return sender_; }
+};
+
 } // namespace detail
 } // namespace stream
 
@@ -0,0 +1,173 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_DETAIL_TAKE_WRITE_HPP_
+#define LIBSTREAM_DETAIL_TAKE_WRITE_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/span.hpp>
+#include <libstream/trace.hpp>
+
+#include <experimental/ranges/range>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Write of a stream which is stopped by its predicate. The predicate is
+ * evaluated when the write is created, the stream stops when the write with
+ * the stopping value is submitted. A write submitted after that completes as
+ * cancelled without reaching the child, unless it is the stopping one.
+ */
+template<class C> class take_write_context
+{
+    sender_slot<C> child_;
+    bool&          stopped_;
+    bool           stops_;
+    bool           has_child_ = false;
+    bool           active_    = false;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    /*
+     * Returns true if the child has to be submitted.
+     */
+    bool start()
+    {
+        if(stops_) { stopped_ = true; }
+        active_ = has_child_ && (stops_ || !stopped_);
+        return active_;
+    }
+
+  public:
+    take_write_context(bool& stopped, bool stops)
+        : stopped_(stopped), stops_(stops)
+    {
+    }
+
+    take_write_context(bool& stopped, bool stops, C&& c)
+        : stopped_(stopped), stops_(stops), has_child_(true)
+    {
+        child_.emplace(std::forward<C>(c));
+    }
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("take_write")
+        if(start()) { child_->submit(); }
+    }
+
+    void submit(base_token&& t)
+    {
+        if(!start()) { t.cancelled(); }
+        else
+        {
+            child_->submit(LIBSTREAM_TRACE_WRAP("take_write", std::move(t)));
+        }
+    }
+
+    void cancel()
+    {
+        if(active_) { child_->cancel(); }
+    }
+};
+
+/*!
+ * The first n values of a range, as span if it is contiguous.
+ */
+template<class R> auto take_prefix(R& r, std::size_t n)
+{
+    namespace ranges = std::experimental::ranges;
+    if constexpr(ranges::ContiguousRange<R>)
+    {
+        using value_type = std::remove_reference_t<decltype(*ranges::data(r))>;
+        return span<value_type>{ranges::data(r), n};
+    }
+    else
+    {
+        using difference_type =
+            ranges::iter_difference_t<ranges::iterator_t<R>>;
+        return ranges::view::take(r, static_cast<difference_type>(n));
+    }
+}
+
+/*!
+ * Writes values until the predicate stops the stream. take_until stops at the
+ * first value satisfying the predicate and still writes it, take_while stops
+ * at the first value not satisfying it and drops it. Range writes only hand
+ * the values up to there to the child. Once the stopping write is submitted,
+ * other writes are not submitted any more until reset() is called.
+ */
+template<WriteStreamable S, class P, bool Until> class take_write_fn
+{
+    S            stream_;
+    P            predicate_;
+    mutable bool stopped_ = false;
+
+    template<class V> bool stops(const V& v) const
+    {
+        return Until == static_cast<bool>(predicate_(v));
+    }
+
+  public:
+    take_write_fn(S&& stream, P p)
+        : stream_(std::forward<S>(stream)), predicate_(std::move(p))
+    {
+    }
+
+    template<std::experimental::ranges::ForwardRange R>
+    auto write(R&& r) const requires PureWriteStreamable<S>
+    {
+        using context_t =
+            take_write_context<decltype(stream_.write(take_prefix(r, 0)))>;
+
+        std::size_t count    = 0;
+        bool        stopping = false;
+        for(const auto& v : r)
+        {
+            if(stops(v))
+            {
+                stopping = true;
+                break;
+            }
+            ++count;
+        }
+        if(stopping && Until) { ++count; }
+
+        if(stopping && count == 0) { return context_t{stopped_, true}; }
+        return context_t{stopped_, stopping,
+                         stream_.write(take_prefix(r, count))};
+    }
+
+    template<class V> auto write(V&& v) const requires PureWriteStreamable<S>
+    {
+        using context_t =
+            take_write_context<decltype(stream_.write(std::forward<V>(v)))>;
+
+        bool stopping = stops(v);
+        if constexpr(!Until)
+        {
+            if(stopping) { return context_t{stopped_, true}; }
+        }
+        return context_t{stopped_, stopping,
+                         stream_.write(std::forward<V>(v))};
+    }
+
+    bool stopped() const noexcept { return stopped_; }
+
+    void reset() noexcept { stopped_ = false; }
+};
+} // namespace detail
+} // namespace stream
+
+#endif /* LIBSTREAM_DETAIL_TAKE_WRITE_HPP_ */
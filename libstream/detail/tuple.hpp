@@ -0,0 +1,36 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_DETAIL_TUPLE_HPP_
+#define LIBSTREAM_DETAIL_TUPLE_HPP_
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+template<class Tuple, class F, std::size_t... I>
+void visit_at(Tuple& t, std::size_t i, F&& f, std::index_sequence<I...>)
+{
+    ((i == I ? f(std::get<I>(t)) : void()), ...);
+}
+
+template<class R, class Tuple, class F, std::size_t... I>
+R invoke_at(Tuple& t, std::size_t i, F&& f, std::index_sequence<I...>)
+{
+    using fn_t                  = R (*)(Tuple&, F&);
+    constexpr fn_t functions[] = {
+        [](Tuple& t, F& f) -> R { return f(std::get<I>(t)); }...};
+    return functions[i](t, f);
+}
+} // namespace detail
+} // namespace stream
+
+#endif // LIBSTREAM_DETAIL_TUPLE_HPP_
@@ -0,0 +1,98 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_DETAIL_WRAP_HPP_
+#define LIBSTREAM_DETAIL_WRAP_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/stream.hpp>
+
+#include <experimental/ranges/range>
+
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Creates Context<Token, C, A> for the sender c, where Token is the token of
+ * the result of c.
+ */
+template<template<class, class, class> class Context, class C, class A>
+auto make_wrap_context(C&& c, A& a)
+{
+    using token_t =
+        typename token_for<decltype(std::declval<C&>().submit())>::type;
+    return Context<token_t, C, A>{std::forward<C>(c), a};
+}
+
+/*!
+ * Stream which forwards all operations to S and wraps every sender in a
+ * Context which is constructed from the sender and a reference to A.
+ */
+template<template<class, class, class> class Context, Streamable S, class A>
+class wrap_fn
+{
+    S  stream_;
+    A& arg_;
+
+  public:
+    wrap_fn(S&& stream, A& a) : stream_(std::forward<S>(stream)), arg_(a) {}
+
+    auto read() const requires PureReadStreamable<S>
+    {
+        return make_wrap_context<Context>(stream_.read(), arg_);
+    }
+
+    template<std::experimental::ranges::Range R>
+    auto read(R&& r) const requires PureReadStreamable<S>
+    {
+        return make_wrap_context<Context>(stream_.read(std::forward<R>(r)),
+                                          arg_);
+    }
+
+    template<std::experimental::ranges::InputRange R>
+    auto write(R&& r) const requires PureWriteStreamable<S>
+    {
+        return make_wrap_context<Context>(stream_.write(std::forward<R>(r)),
+                                          arg_);
+    }
+
+    template<class V> auto write(V&& v) const requires PureWriteStreamable<S>
+    {
+        return make_wrap_context<Context>(stream_.write(std::forward<V>(v)),
+                                          arg_);
+    }
+
+    template<std::experimental::ranges::ForwardRange R>
+    auto writev(R&& segments) const requires VectoredWriteStreamable<S, R>
+    {
+        return make_wrap_context<Context>(
+            stream_.writev(std::forward<R>(segments)), arg_);
+    }
+
+    template<class V>
+    auto readwrite(V&& v) const requires ReadWriteStreamable<S>
+    {
+        return make_wrap_context<Context>(
+            stream_.readwrite(std::forward<V>(v)), arg_);
+    }
+
+    template<std::experimental::ranges::InputRange Rin,
+             std::experimental::ranges::Range      Rout>
+    auto readwrite(Rin&& rin, Rout&& rout) const requires ReadWriteStreamable<S>
+    {
+        return make_wrap_context<Context>(
+            stream_.readwrite(std::forward<Rin>(rin), std::forward<Rout>(rout)),
+            arg_);
+    }
+};
+} // namespace detail
+} // namespace stream
+
+#endif // LIBSTREAM_DETAIL_WRAP_HPP_
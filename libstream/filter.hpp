@@ -11,12 +11,86 @@
 #include <liboutput_view/filter.hpp>
 #include <libstream/concepts/pipe.hpp>
 #include <libstream/concepts/stream.hpp>
+#include <libstream/connect.hpp>
 #include <libstream/detail/context.hpp>
+#include <libstream/fused.hpp>
+#include <libstream/kernel.hpp>
+#include <libstream/span.hpp>
 
 #include <experimental/ranges/range>
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
 namespace stream
 {
+/*!
+ * Accepts values within [low, high], e.g. to drop invalid samples.
+ * filter_read() compacts contiguous ranges with it in bulk.
+ */
+template<class T> struct within_predicate
+{
+    static_assert(std::is_arithmetic_v<T>,
+                  "Only arithmetic types are compared in bulk.");
+
+    using value_type = T;
+
+    T low;
+    T high;
+
+    constexpr bool operator()(const T& v) const noexcept
+    {
+        return low <= v && v <= high;
+    }
+
+    std::size_t compact(span<T> r) const noexcept
+    {
+        return detail::compact(r,
+                               [l = low, h = high](detail::simd_t<T> v) {
+                                   return (v >= l) & (v <= h);
+                               },
+                               *this);
+    }
+};
+
+/*!
+ * Accepts all values but one, e.g. to drop a sentinel. filter_read()
+ * compacts contiguous ranges with it in bulk.
+ */
+template<class T> struct not_equal_predicate
+{
+    static_assert(std::is_arithmetic_v<T>,
+                  "Only arithmetic types are compared in bulk.");
+
+    using value_type = T;
+
+    T value;
+
+    constexpr bool operator()(const T& v) const noexcept { return v != value; }
+
+    std::size_t compact(span<T> r) const noexcept
+    {
+        return detail::compact(
+            r, [x = value](detail::simd_t<T> v) { return v != x; }, *this);
+    }
+};
+
+/*!
+ * A predicate which, besides single values, moves the accepted values of a
+ * span to its front and returns their number.
+ */
+template<class P, class T>
+concept bool BulkPredicate =
+    std::is_same_v<typename std::remove_reference_t<P>::value_type, T> &&
+    requires(const std::remove_reference_t<P>& p, span<T> r)
+{
+    p.compact(r);
+};
+
 namespace detail
 {
 template<class C> struct write_filter_context
@@ -55,6 +129,49 @@ template<class C> struct write_filter_context
 
 template<class C> write_filter_context(bool, C&& c)->write_filter_context<C>;
 
+/*!
+ * A read_filter_context connected to a receiver. Rejected values restart the
+ * child through the trampoline.
+ */
+template<class C, class S, class R> class read_filter_operation
+{
+    using value_type = decltype(std::declval<C&>().submit());
+
+    struct receiver
+    {
+        read_filter_operation* op_;
+
+        void done(value_type v)
+        {
+            if(op_->stream_.predicate_(v)) { op_->receiver_.done(v); }
+            else
+            {
+                op_->start();
+            }
+        }
+        void error(error_code e) { op_->receiver_.error(e); }
+        void cancelled() { op_->receiver_.cancelled(); }
+    };
+
+    S&                            stream_;
+    R                             receiver_;
+    trampoline                    trampoline_;
+    connect_result_t<C, receiver> child_;
+
+  public:
+    read_filter_operation(C&& c, S& s, R&& r)
+        : stream_(s), receiver_(std::forward<R>(r)),
+          child_(stream::connect(std::forward<C>(c), receiver{this}))
+    {
+    }
+
+    void start()
+    {
+        trampoline_.run([this] { child_.start(); });
+    }
+    void cancel() { child_.cancel(); }
+};
+
 template<class C, class S>
 class read_filter_context : public base_read_context<C>
 {
@@ -63,6 +180,7 @@ class read_filter_context : public base_read_context<C>
     S& stream_;
 
     read_token<value_type> token_;
+    trampoline             trampoline_;
 
     void submit_internal()
     {
@@ -78,7 +196,7 @@ class read_filter_context : public base_read_context<C>
         if(stream_.predicate_(v)) { token_.done(v); }
         else
         {
-            submit_internal();
+            trampoline_.run([this] { submit_internal(); });
         }
     }
 
@@ -90,6 +208,7 @@ class read_filter_context : public base_read_context<C>
 
     auto submit() noexcept
     {
+        LIBSTREAM_TRACE_SYNC("filter_read")
         while(true)
         {
             auto result = child_.submit();
@@ -99,13 +218,191 @@ class read_filter_context : public base_read_context<C>
 
     void submit(read_token<value_type>&& t)
     {
-        token_ = t;
-        submit_internal();
+        token_ = LIBSTREAM_TRACE_WRAP("filter_read", std::move(t));
+        trampoline_.run([this] { submit_internal(); });
+    }
+
+    using base_read_context<C>::cancel;
+
+    template<class R> auto connect(R&& r) &&
+    {
+        return read_filter_operation<C, S, R>{std::forward<C>(child_),
+                                              stream_, std::forward<R>(r)};
     }
 };
 
 template<class C, class S>
 read_filter_context(C&& c, S& s)->read_filter_context<C, S>;
+
+/*!
+ * Reads straight into a contiguous range and compacts the accepted values to
+ * its front. The rest of the range is read again until it is filled with
+ * accepted values.
+ */
+template<class S, class T, class P> class bulk_filter_read_context
+{
+    using this_t  = bulk_filter_read_context<S, T, P>;
+    using child_t = decltype(std::declval<S&>().read(std::declval<span<T>>()));
+
+    S&                   stream_;
+    span<T>              range_;
+    const P&             predicate_;
+    std::size_t          filled_ = 0;
+    sender_slot<child_t> child_;
+    base_token           token_;
+    trampoline           trampoline_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    span<T> rest() const
+    {
+        return {range_.data() + filled_, range_.size() - filled_};
+    }
+
+    bool compact()
+    {
+        filled_ += predicate_.compact(rest());
+        return filled_ == range_.size();
+    }
+
+    void submit_internal()
+    {
+        child_.emplace(stream_.read(rest()));
+        child_->submit(base_token{
+            token_.error, token_.cancelled,
+            done_token::template create<this_t, &this_t::done_handler>(this)});
+    }
+
+    void done_handler()
+    {
+        if(compact()) { token_.done(); }
+        else
+        {
+            trampoline_.run(child_, [this] { submit_internal(); });
+        }
+    }
+
+  public:
+    bulk_filter_read_context(S& s, span<T> r, const P& p)
+        : stream_(s), range_(r), predicate_(p)
+    {
+    }
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("filter_read_bulk")
+        filled_ = 0;
+        do
+        {
+            child_.emplace(stream_.read(rest()));
+            child_->submit();
+        } while(!compact());
+    }
+
+    void submit(base_token&& t)
+    {
+        token_  = LIBSTREAM_TRACE_WRAP("filter_read_bulk", std::move(t));
+        filled_ = 0;
+        trampoline_.run(child_, [this] { submit_internal(); });
+    }
+
+    void cancel()
+    {
+        if(child_) { child_->cancel(); }
+    }
+};
+
+template<class S, class T, class P>
+bulk_filter_read_context(S& s, span<T> r, const P& p)
+    ->bulk_filter_read_context<S, T, P>;
+
+/*!
+ * Maximal runs of consecutive elements of a contiguous range which satisfy
+ * the predicate, as spans into the range.
+ */
+template<class T, class P>
+class filter_runs : public std::experimental::ranges::view_base
+{
+    T*       first_     = nullptr;
+    T*       last_      = nullptr;
+    const P* predicate_ = nullptr;
+
+  public:
+    class iterator
+    {
+        T*       run_first_ = nullptr;
+        T*       run_last_  = nullptr;
+        T*       last_      = nullptr;
+        const P* predicate_ = nullptr;
+
+        void find(T* from)
+        {
+            run_first_ = std::find_if(from, last_, std::cref(*predicate_));
+            run_last_ =
+                std::find_if_not(run_first_, last_, std::cref(*predicate_));
+        }
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = span<T>;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = span<T>;
+        using pointer           = void;
+
+        iterator() = default;
+        iterator(T* first, T* last, const P* predicate)
+            : last_(last), predicate_(predicate)
+        {
+            find(first);
+        }
+
+        span<T> operator*() const { return {run_first_, run_last_}; }
+
+        iterator& operator++()
+        {
+            find(run_last_);
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto i = *this;
+            ++*this;
+            return i;
+        }
+
+        friend bool operator==(const iterator& x, const iterator& y)
+        {
+            return x.run_first_ == y.run_first_;
+        }
+
+        friend bool operator!=(const iterator& x, const iterator& y)
+        {
+            return !(x == y);
+        }
+    };
+
+    filter_runs() = default;
+    filter_runs(T* first, T* last, const P& predicate)
+        : first_(first), last_(last), predicate_(&predicate)
+    {
+    }
+
+    iterator begin() const { return {first_, last_, predicate_}; }
+    iterator end() const { return {last_, last_, predicate_}; }
+};
+
+template<class R, class P>
+using filter_runs_t = filter_runs<std::remove_reference_t<decltype(
+                                      *std::experimental::ranges::data(
+                                          std::declval<R&>()))>,
+                                  P>;
+
+template<class R, class P>
+filter_runs_t<R, P> make_filter_runs(R& r, const P& p)
+{
+    namespace ranges = std::experimental::ranges;
+    return {ranges::data(r), ranges::data(r) + ranges::size(r), p};
+}
 } // namespace detail
 
 template<WriteStreamable S, class P> class filter_write_fn
@@ -140,6 +437,18 @@ template<WriteStreamable S, class P> class filter_write_fn
                 std::forward<R>(r), predicate_))};
     }
 
+    /*!
+     * Hands a stream which supports vectored writes the runs of accepted
+     * elements of the range as segments, instead of a lazy view.
+     */
+    template<std::experimental::ranges::ContiguousRange R>
+    auto write(R&& r) const
+        requires VectoredWriteStreamable<S, detail::filter_runs_t<R, P>>
+    {
+        return detail::base_range_context{
+            stream_.writev(detail::make_filter_runs(r, predicate_))};
+    }
+
     template<std::experimental::ranges::InputRange Rin,
              std::experimental::ranges::Range      Rout>
     auto readwrite(Rin&& rin, Rout&& rout) const requires ReadWriteStreamable<S>
@@ -203,6 +512,18 @@ template<ReadStreamable S, class P> class filter_read_fn
             stream_.read(output_view::filter(std::forward<R>(r), predicate_))};
     }
 
+    template<std::experimental::ranges::ContiguousRange R>
+    auto read(R&& r) const requires PureReadStreamable<S> &&
+        BulkPredicate<P, detail::contiguous_value_t<R>>
+    {
+        namespace ranges = std::experimental::ranges;
+        return detail::bulk_filter_read_context{
+            stream_,
+            span<detail::contiguous_value_t<R>>{ranges::data(r),
+                                                ranges::size(r)},
+            predicate_};
+    }
+
     template<class V>
     auto readwrite(V&& v) const requires ReadWriteStreamable<S>
     {
@@ -241,6 +562,8 @@ template<class F> class filter_read_pipe
     {
         return filter_read_fn<S, F>{std::forward<S>(s), F(f_)};
     }
+
+    auto read_ops() const { return std::tuple{detail::filter_op<F>{f_}}; }
 };
 
 template<class F> Pipeable filter_read(F&& f)
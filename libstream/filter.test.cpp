@@ -171,6 +171,80 @@ SCENARIO("Filter reads.")
     }
 }
 
+SCENARIO("Bulk filter reads.")
+{
+    GIVEN("A read stream that drops 0 in bulk.")
+    {
+        read_mock reader;
+        auto      s = stream::filter_read(reader, not_equal_predicate<int>{0});
+        array     a{0, 0, 0};
+        auto      sender = s.read(a);
+
+        vector<vector<int>> reads{{1, 0, 2}, {3}};
+        size_t              i = 0;
+        REQUIRE_CALL(reader, read_(_))
+            .TIMES(2)
+            .LR_SIDE_EFFECT(_1 = reads[i++]);
+
+        WHEN("Synchronous submit is called.")
+        {
+            REQUIRE_CALL(reader.range_sender_, submit()).TIMES(2);
+            sender.submit();
+
+            THEN("The rest of the range is read again.")
+            {
+                REQUIRE_THAT(a, Equals(array{1, 2, 3}));
+            }
+        }
+
+        WHEN("Asynchronous submit is called.")
+        {
+            base_token t;
+            REQUIRE_CALL(reader.range_sender_, submit(ANY(base_token)))
+                .TIMES(2)
+                .LR_SIDE_EFFECT(t = _1);
+            done_callback_mock   callback_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+            t.done();
+
+            THEN("It completes once the range is filled.")
+            {
+                REQUIRE_CALL(callback_mock, call());
+                t.done();
+                REQUIRE_THAT(a, Equals(array{1, 2, 3}));
+            }
+        }
+    }
+
+    GIVEN("A bulk filtered read which was not submitted.")
+    {
+        read_mock reader;
+        auto      s = stream::filter_read(reader, not_equal_predicate<int>{0});
+        array     a{0, 0, 0};
+        auto      sender = s.read(a);
+
+        THEN("Cancelling it does nothing.") { sender.cancel(); }
+    }
+
+    THEN("Whole and partial blocks are compacted like single values.")
+    {
+        within_predicate<int> p{2, 9};
+        for(size_t n = 0; n < 70; ++n)
+        {
+            vector<int> values(n), accepted;
+            for(size_t i = 0; i < n; ++i)
+            {
+                values[i] = static_cast<int>(i * 7 % 13);
+                if(p(values[i])) { accepted.push_back(values[i]); }
+            }
+            values.resize(p.compact({values.data(), n}));
+            REQUIRE(values == accepted);
+        }
+    }
+}
+
 SCENARIO("Cancelling operations.")
 {
     GIVEN("A write stream that adds one.")
@@ -349,3 +423,45 @@ SCENARIO("Double filter")
         }
     }
 }
+
+struct inline_reader
+{
+    int rejected_;
+
+    struct sender
+    {
+        inline_reader& reader_;
+
+        int submit() { return reader_.next(); }
+        void submit(read_token<int>&& t) { t.done(reader_.next()); }
+        void cancel() {}
+    };
+
+    int next() { return rejected_-- > 0 ? 0 : 1; }
+
+    sender read() { return sender{*this}; }
+};
+
+SCENARIO("Inline completions")
+{
+    GIVEN("A reader that completes inline with a long run of zeros.")
+    {
+        inline_reader reader{1000000};
+        auto s = stream::filter_read(reader, [](auto v) { return v != 0; });
+        auto sender = s.read();
+
+        WHEN("Asynchronous submit is called.")
+        {
+            read_callback_mock   callback_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+
+            THEN("The zeros are skipped without exhausting the stack.")
+            {
+                REQUIRE_CALL(callback_mock, call(1));
+                sender.submit(
+                    read_token<int>{error_mock, cancel_mock, callback_mock});
+            }
+        }
+    }
+}
@@ -0,0 +1,512 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_FRAMING_HPP_
+#define LIBSTREAM_FRAMING_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/span.hpp>
+#include <libstream/trace.hpp>
+
+#include <experimental/ranges/range>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+/*!
+ * Upper bounds of the encoded size of a frame with n payload bytes, including
+ * its delimiters. They bound the scratch buffer of the encoding stages.
+ */
+constexpr std::size_t cobs_encoded_size(std::size_t n)
+{
+    return n + n / 254 + 2;
+}
+
+constexpr std::size_t slip_encoded_size(std::size_t n)
+{
+    return 2 * n + 2;
+}
+
+namespace detail
+{
+/*!
+ * Consistent Overhead Byte Stuffing. Frames are terminated by a zero byte,
+ * every block of up to 254 non-zero bytes is preceded by its length plus one.
+ */
+struct cobs
+{
+    /*!
+     * Encodes a range of bytes into out and returns the encoded size, or 0 if
+     * it does not fit.
+     */
+    template<class R, class T> static std::size_t encode(R& r, span<T> out)
+    {
+        T* const          p = out.data();
+        const std::size_t n = out.size();
+        if(n < 2) { return 0; }
+
+        std::size_t  code_at = 0;
+        std::size_t  next    = 1;
+        std::uint8_t code    = 1;
+        for(const auto& v : r)
+        {
+            const auto b = static_cast<std::uint8_t>(v);
+            if(b != 0)
+            {
+                if(next == n) { return 0; }
+                p[next++] = static_cast<T>(b);
+                ++code;
+            }
+            if(b == 0 || code == 0xFF)
+            {
+                if(next == n) { return 0; }
+                p[code_at] = static_cast<T>(code);
+                code_at    = next++;
+                code       = 1;
+            }
+        }
+        if(next == n) { return 0; }
+        p[code_at] = static_cast<T>(code);
+        p[next++]  = T{};
+        return next;
+    }
+
+    /*!
+     * Decodes one byte into the frame and returns whether it ended the frame.
+     */
+    class decoder
+    {
+        std::uint8_t remaining_ = 0;
+        bool         zero_      = false;
+        bool         started_   = false;
+
+      public:
+        template<class F> bool feed(std::uint8_t b, F& frame)
+        {
+            if(b == 0)
+            {
+                // Consecutive delimiters enclose no frame.
+                if(!started_) { return false; }
+                if(remaining_ != 0) { frame.fail(EBADMSG); }
+                *this = decoder{};
+                return true;
+            }
+
+            started_ = true;
+            if(remaining_ == 0)
+            {
+                if(zero_) { frame.put(0); }
+                remaining_ = b - 1;
+                zero_      = b != 0xFF;
+            }
+            else
+            {
+                frame.put(b);
+                --remaining_;
+            }
+            return false;
+        }
+    };
+};
+
+/*!
+ * Serial Line IP, RFC 1055. Frames are enclosed by END bytes, END and ESC in
+ * the payload are replaced by ESC ESC_END and ESC ESC_ESC. As in the RFC,
+ * empty frames are skipped by the decoder.
+ */
+struct slip
+{
+    static constexpr std::uint8_t end     = 0xC0;
+    static constexpr std::uint8_t esc     = 0xDB;
+    static constexpr std::uint8_t esc_end = 0xDC;
+    static constexpr std::uint8_t esc_esc = 0xDD;
+
+    template<class R, class T> static std::size_t encode(R& r, span<T> out)
+    {
+        T* const          p    = out.data();
+        const std::size_t n    = out.size();
+        std::size_t       next = 0;
+
+        auto put = [&](std::uint8_t b) {
+            if(next == n) { return false; }
+            p[next++] = static_cast<T>(b);
+            return true;
+        };
+
+        if(!put(end)) { return 0; }
+        for(const auto& v : r)
+        {
+            const auto b  = static_cast<std::uint8_t>(v);
+            bool       ok = true;
+            if(b == end) { ok = put(esc) && put(esc_end); }
+            else if(b == esc)
+            {
+                ok = put(esc) && put(esc_esc);
+            }
+            else
+            {
+                ok = put(b);
+            }
+            if(!ok) { return 0; }
+        }
+        return put(end) ? next : 0;
+    }
+
+    class decoder
+    {
+        bool escaped_ = false;
+        bool started_ = false;
+
+      public:
+        template<class F> bool feed(std::uint8_t b, F& frame)
+        {
+            if(b == end)
+            {
+                // The leading END of a frame encloses no frame.
+                if(!started_) { return false; }
+                *this = decoder{};
+                return true;
+            }
+
+            started_ = true;
+            if(escaped_)
+            {
+                escaped_ = false;
+                if(b == esc_end) { frame.put(end); }
+                else if(b == esc_esc)
+                {
+                    frame.put(esc);
+                }
+                else
+                {
+                    frame.fail(EBADMSG);
+                }
+            }
+            else if(b == esc)
+            {
+                escaped_ = true;
+            }
+            else
+            {
+                frame.put(b);
+            }
+            return false;
+        }
+    };
+};
+
+/*!
+ * Write of an encoded frame. A frame which did not fit into the scratch
+ * buffer is not submitted to the child and completes with its error.
+ */
+template<class C> class frame_write_context
+{
+    sender_slot<C> child_;
+    error_code     error_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+  public:
+    explicit frame_write_context(error_code e) : error_(e) {}
+
+    explicit frame_write_context(C&& c) : error_(0)
+    {
+        child_.emplace(std::forward<C>(c));
+    }
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("frame_write")
+        if(error_ == 0) { child_->submit(); }
+    }
+
+    void submit(base_token&& t)
+    {
+        if(error_ != 0) { t.error(error_); }
+        else
+        {
+            child_->submit(LIBSTREAM_TRACE_WRAP("frame_write", std::move(t)));
+        }
+    }
+
+    void cancel()
+    {
+        if(error_ == 0) { child_->cancel(); }
+    }
+
+    error_code error() const noexcept { return error_; }
+};
+
+/*!
+ * Destination of a decoded frame. Bytes beyond the end of the range are
+ * dropped and fail the frame with EMSGSIZE.
+ */
+template<class R, class T> class frame_sink
+{
+    std::experimental::ranges::iterator_t<R> next_;
+    std::experimental::ranges::sentinel_t<R> last_;
+    std::size_t                              size_  = 0;
+    error_code                               error_ = 0;
+
+  public:
+    explicit frame_sink(R& r)
+        : next_(std::experimental::ranges::begin(r)),
+          last_(std::experimental::ranges::end(r))
+    {
+    }
+
+    void put(std::uint8_t b)
+    {
+        if(next_ == last_) { fail(EMSGSIZE); }
+        else
+        {
+            *next_ = static_cast<T>(b);
+            ++next_;
+            ++size_;
+        }
+    }
+
+    void fail(error_code e)
+    {
+        if(error_ == 0) { error_ = e; }
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    error_code  error() const noexcept { return error_; }
+};
+
+/*!
+ * Reads single values from the stream and decodes them into the range until
+ * a frame ended. Resubmissions run through a trampoline, so a stream which
+ * completes inline does not recurse.
+ */
+template<class S, class R, class D> class frame_decode_context
+{
+    using this_t     = frame_decode_context<S, R, D>;
+    using child_t    = decltype(std::declval<S&>().read());
+    using value_type = decltype(std::declval<child_t&>().submit());
+    using sink_t     = frame_sink<std::remove_reference_t<R>, value_type>;
+
+    S&                    stream_;
+    R                     range_;
+    D                     decoder_;
+    std::optional<sink_t> frame_;
+    sender_slot<child_t>  child_;
+    base_token            token_;
+    trampoline            trampoline_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    bool feed(value_type v)
+    {
+        return decoder_.feed(static_cast<std::uint8_t>(v), *frame_);
+    }
+
+    void start()
+    {
+        decoder_ = D{};
+        frame_.emplace(range_);
+    }
+
+    void submit_internal()
+    {
+        child_.emplace(stream_.read());
+        child_->submit(read_token<value_type>{
+            token_.error, token_.cancelled,
+            read_done_token<value_type>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    void done_handler(value_type v)
+    {
+        if(!feed(v))
+        {
+            trampoline_.run(child_, [this] { submit_internal(); });
+        }
+        else if(frame_->error() != 0)
+        {
+            token_.error(frame_->error());
+        }
+        else
+        {
+            token_.done();
+        }
+    }
+
+  public:
+    frame_decode_context(S& s, R&& r) : stream_(s), range_(std::forward<R>(r))
+    {
+    }
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("frame_decode")
+        start();
+        do
+        {
+            child_.emplace(stream_.read());
+        } while(!feed(child_->submit()));
+    }
+
+    void submit(base_token&& t)
+    {
+        token_ = LIBSTREAM_TRACE_WRAP("frame_decode", std::move(t));
+        start();
+        trampoline_.run(child_, [this] { submit_internal(); });
+    }
+
+    void cancel()
+    {
+        if(child_) { child_->cancel(); }
+    }
+
+    /*!
+     * Number of values of the last decoded frame.
+     */
+    std::size_t size() const noexcept { return frame_ ? frame_->size() : 0; }
+
+    /*!
+     * EMSGSIZE if the last frame did not fit into the range, EBADMSG if it was
+     * malformed, 0 otherwise. Asynchronous reads report it to the token.
+     */
+    error_code error() const noexcept { return frame_ ? frame_->error() : 0; }
+};
+} // namespace detail
+
+/*!
+ * Encodes every range written into one frame in a scratch buffer of N values
+ * held by the stream and writes the frame to the stream in one piece. The
+ * scratch buffer is reused for every frame, so a frame has to be written
+ * before the next one is encoded. Frames which do not fit fail with EMSGSIZE.
+ */
+template<PureWriteStreamable S, class T, std::size_t N, class Codec>
+class frame_encode_write_fn
+{
+    static_assert(sizeof(T) == 1, "Frames are encoded into bytes.");
+
+    S                        stream_;
+    mutable std::array<T, N> scratch_{};
+
+  public:
+    frame_encode_write_fn(S&& stream) : stream_(std::forward<S>(stream)) {}
+
+    template<std::experimental::ranges::InputRange R> auto write(R&& r) const
+    {
+        using context_t = detail::frame_write_context<decltype(
+            stream_.write(std::declval<span<const T>>()))>;
+
+        const auto n = Codec::encode(r, span<T>{scratch_.data(), N});
+        if(n == 0) { return context_t{EMSGSIZE}; }
+        return context_t{stream_.write(span<const T>{scratch_.data(), n})};
+    }
+};
+
+/*!
+ * Reads one frame into a range per read. The sender's size() reports the
+ * number of decoded values.
+ */
+template<PureReadStreamable S, class Codec> class frame_decode_read_fn
+{
+    S stream_;
+
+  public:
+    frame_decode_read_fn(S&& stream) : stream_(std::forward<S>(stream)) {}
+
+    template<std::experimental::ranges::Range R> auto read(R&& r) const
+    {
+        return detail::frame_decode_context<
+            std::remove_reference_t<decltype((stream_))>, R,
+            typename Codec::decoder>{stream_, std::forward<R>(r)};
+    }
+};
+
+template<class T, std::size_t N, class Codec> struct frame_encode_write_pipe
+{
+    template<PureWriteStreamable S> WriteStreamable pipe(S&& s) const
+    {
+        return frame_encode_write_fn<S, T, N, Codec>{std::forward<S>(s)};
+    }
+};
+
+template<class Codec> struct frame_decode_read_pipe
+{
+    template<PureReadStreamable S> ReadStreamable pipe(S&& s) const
+    {
+        return frame_decode_read_fn<S, Codec>{std::forward<S>(s)};
+    }
+};
+
+/*!
+ * Writes every range as one COBS frame of values of type T. N bounds the
+ * encoded frame, see cobs_encoded_size().
+ */
+template<class T, std::size_t N> Pipeable cobs_encode_write()
+{
+    return frame_encode_write_pipe<T, N, detail::cobs>{};
+}
+
+template<class T, std::size_t N, PureWriteStreamable S>
+WriteStreamable cobs_encode_write(S&& stream)
+{
+    return frame_encode_write_fn<S, T, N, detail::cobs>{
+        std::forward<S>(stream)};
+}
+
+/*!
+ * Reads one COBS frame per range read.
+ */
+inline Pipeable cobs_decode_read()
+{
+    return frame_decode_read_pipe<detail::cobs>{};
+}
+
+template<PureReadStreamable S> ReadStreamable cobs_decode_read(S&& stream)
+{
+    return frame_decode_read_fn<S, detail::cobs>{
+        std::forward<S>(stream)};
+}
+
+/*!
+ * Writes every range as one SLIP frame of values of type T. N bounds the
+ * encoded frame, see slip_encoded_size().
+ */
+template<class T, std::size_t N> Pipeable slip_encode_write()
+{
+    return frame_encode_write_pipe<T, N, detail::slip>{};
+}
+
+template<class T, std::size_t N, PureWriteStreamable S>
+WriteStreamable slip_encode_write(S&& stream)
+{
+    return frame_encode_write_fn<S, T, N, detail::slip>{
+        std::forward<S>(stream)};
+}
+
+/*!
+ * Reads one SLIP frame per range read.
+ */
+inline Pipeable slip_decode_read()
+{
+    return frame_decode_read_pipe<detail::slip>{};
+}
+
+template<PureReadStreamable S> ReadStreamable slip_decode_read(S&& stream)
+{
+    return frame_decode_read_fn<S, detail::slip>{
+        std::forward<S>(stream)};
+}
+} // namespace stream
+
+#endif /* LIBSTREAM_FRAMING_HPP_ */
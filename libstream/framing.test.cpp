@@ -0,0 +1,393 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/framing.hpp>
+
+#include <libstream/filter.hpp>
+#include <libstream/kernel.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/range_matcher.hpp>
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+/*
+ * Read stream which returns its senders by value. A sender touches its own
+ * state after its completion handler returned, like a sender which owns an
+ * operation of an event loop.
+ */
+struct owning_reader
+{
+    struct sender
+    {
+        owning_reader*  stream_;
+        unique_ptr<int> completions_ = make_unique<int>(0);
+        read_token<int> token_;
+
+        int  submit() { return stream_->wire_[stream_->next_++]; }
+        void submit(read_token<int>&& t)
+        {
+            token_            = t;
+            stream_->pending_ = this;
+        }
+        void cancel() {}
+
+        void complete()
+        {
+            auto* completions = completions_.get();
+            stream_->pending_ = nullptr;
+            token_.done(stream_->wire_[stream_->next_++]);
+            ++*completions;
+        }
+    };
+
+    vector<int> wire_;
+    size_t      next_    = 0;
+    sender*     pending_ = nullptr;
+
+    sender read() { return sender{this}; }
+};
+} // namespace
+
+SCENARIO("COBS encoding.")
+{
+    GIVEN("A stream that encodes COBS frames.")
+    {
+        write_mock writer;
+        auto       s = stream::cobs_encode_write<uint8_t, 8>(writer);
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(writer, write_(vector{3, 0x11, 0x22, 2, 0x33, 0}));
+            array a{0x11, 0x22, 0, 0x33};
+            auto  sender = s.write(a);
+            REQUIRE(sender.error() == 0);
+
+            test_sync_submit(writer.range_sender_, sender);
+            test_async_range_submit(writer.range_sender_, sender);
+            test_async_range_submit(writer.range_sender_, sender, dummy_error);
+        }
+
+        WHEN("A single zero is written.")
+        {
+            REQUIRE_CALL(writer, write_(vector{1, 1, 0}));
+            array a{0};
+            s.write(a);
+        }
+
+        WHEN("A range which does not fit is written.")
+        {
+            array a{1, 2, 3, 4, 5, 6, 7};
+            auto  sender = s.write(a);
+            REQUIRE(sender.error() == EMSGSIZE);
+
+            THEN("It fails without writing.")
+            {
+                sender.submit();
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+                REQUIRE_CALL(error_mock, call(EMSGSIZE));
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+            }
+        }
+    }
+
+    THEN("Long blocks are split.")
+    {
+        REQUIRE(cobs_encoded_size(254) == 257);
+
+        write_mock writer;
+        auto       s =
+            stream::cobs_encode_write<uint8_t, cobs_encoded_size(254)>(writer);
+        vector<int> a(254, 1);
+        vector<int> expected(257, 1);
+        expected[0]   = 0xFF;
+        expected[256] = 0;
+        REQUIRE_CALL(writer, write_(expected));
+        s.write(a);
+    }
+}
+
+SCENARIO("COBS decoding.")
+{
+    GIVEN("A stream that decodes COBS frames.")
+    {
+        read_mock reader;
+        auto      s = stream::cobs_decode_read(reader);
+
+        vector<int> wire;
+        size_t      i = 0;
+        ALLOW_CALL(reader, read()).LR_RETURN(reader.sender_);
+        ALLOW_CALL(reader.sender_, submit()).LR_RETURN(wire[i++]);
+        ALLOW_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .LR_SIDE_EFFECT(_1.done(wire[i++]));
+
+        done_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        WHEN("A frame is read synchronously.")
+        {
+            wire = {0, 3, 0x11, 0x22, 2, 0x33, 0};
+            array a{0, 0, 0, 0, 0};
+            auto  sender = s.read(a);
+            sender.submit();
+
+            THEN("Leading delimiters are skipped and the frame is decoded.")
+            {
+                REQUIRE(i == wire.size());
+                REQUIRE(sender.error() == 0);
+                REQUIRE(sender.size() == 4);
+                REQUIRE_THAT(a, Equals(array{0x11, 0x22, 0, 0x33, 0}));
+            }
+        }
+
+        WHEN("A frame is read asynchronously.")
+        {
+            wire = {3, 0x11, 0x22, 2, 0x33, 0};
+            array a{0, 0, 0, 0};
+            auto  sender = s.read(a);
+
+            REQUIRE_CALL(callback_mock, call());
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+            REQUIRE(sender.size() == 4);
+            REQUIRE_THAT(a, Equals(array{0x11, 0x22, 0, 0x33}));
+        }
+
+        WHEN("A frame is longer than the range.")
+        {
+            wire = {4, 1, 2, 3, 0, 2, 5, 0};
+            array a{0, 0};
+            auto  sender = s.read(a);
+
+            REQUIRE_CALL(error_mock, call(EMSGSIZE));
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+
+            THEN("The rest of the frame is skipped.")
+            {
+                REQUIRE(i == 5);
+                auto next = s.read(a);
+                next.submit();
+                REQUIRE(next.error() == 0);
+                REQUIRE(next.size() == 1);
+                REQUIRE(a[0] == 5);
+            }
+        }
+
+        WHEN("A frame ends within a block.")
+        {
+            wire = {3, 1, 0};
+            array a{0, 0};
+            auto  sender = s.read(a);
+
+            REQUIRE_CALL(error_mock, call(EBADMSG));
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+        }
+
+        WHEN("The operation is cancelled.")
+        {
+            array a{0, 0};
+            auto  sender = s.read(a);
+
+            read_token<int> t;
+            REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+
+            REQUIRE_CALL(reader.sender_, cancel());
+            sender.cancel();
+
+            REQUIRE_CALL(cancel_mock, call());
+            t.cancelled();
+        }
+
+        WHEN("The operation is cancelled before it is submitted.")
+        {
+            array a{0, 0};
+            s.read(a).cancel();
+        }
+    }
+
+    GIVEN("A stream whose reads complete asynchronously.")
+    {
+        owning_reader reader;
+        auto          s = stream::cobs_decode_read(reader);
+
+        done_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        WHEN("A frame is read.")
+        {
+            reader.wire_ = {3, 0x11, 0x22, 2, 0x33, 0};
+            array a{0, 0, 0, 0};
+            auto  sender = s.read(a);
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+
+            THEN("Every value is read from within the previous completion.")
+            {
+                REQUIRE_CALL(callback_mock, call());
+                while(reader.pending_ != nullptr)
+                {
+                    reader.pending_->complete();
+                }
+                REQUIRE(reader.next_ == reader.wire_.size());
+                REQUIRE_THAT(a, Equals(array{0x11, 0x22, 0, 0x33}));
+            }
+        }
+    }
+}
+
+SCENARIO("SLIP encoding.")
+{
+    GIVEN("A stream that encodes SLIP frames.")
+    {
+        write_mock writer;
+        auto       s = stream::slip_encode_write<uint8_t, 8>(writer);
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(writer,
+                         write_(vector{0xC0, 1, 0xDB, 0xDC, 0xDB, 0xDD, 0xC0}));
+            array a{1, 0xC0, 0xDB};
+            auto  sender = s.write(a);
+
+            test_sync_submit(writer.range_sender_, sender);
+            test_async_range_submit(writer.range_sender_, sender);
+        }
+
+        WHEN("A range which does not fit is written.")
+        {
+            array a{0xC0, 0xC0, 0xC0, 0xC0};
+            REQUIRE(s.write(a).error() == EMSGSIZE);
+        }
+    }
+}
+
+SCENARIO("SLIP decoding.")
+{
+    GIVEN("A stream that decodes SLIP frames.")
+    {
+        read_mock reader;
+        auto      s = stream::slip_decode_read(reader);
+
+        vector<int> wire;
+        size_t      i = 0;
+        ALLOW_CALL(reader, read()).LR_RETURN(reader.sender_);
+        ALLOW_CALL(reader.sender_, submit()).LR_RETURN(wire[i++]);
+        ALLOW_CALL(reader.sender_, submit(ANY(read_token<int>)))
+            .LR_SIDE_EFFECT(_1.done(wire[i++]));
+
+        done_callback_mock   callback_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+
+        WHEN("A frame is read.")
+        {
+            wire = {0xC0, 0xC0, 1, 0xDB, 0xDC, 0xDB, 0xDD, 0xC0};
+            array a{0, 0, 0, 0};
+            auto  sender = s.read(a);
+
+            REQUIRE_CALL(callback_mock, call());
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+            REQUIRE(sender.size() == 3);
+            REQUIRE_THAT(a, Equals(array{1, 0xC0, 0xDB, 0}));
+        }
+
+        WHEN("A frame contains an invalid escape.")
+        {
+            wire = {0xC0, 0xDB, 1, 0xC0, 2, 0xC0};
+            array a{0, 0};
+            auto  sender = s.read(a);
+            sender.submit();
+            REQUIRE(sender.error() == EBADMSG);
+
+            THEN("The next frame is read.")
+            {
+                auto next = s.read(a);
+                next.submit();
+                REQUIRE(next.error() == 0);
+                REQUIRE(next.size() == 1);
+                REQUIRE(a[0] == 2);
+            }
+        }
+    }
+}
+
+SCENARIO("Framing combined with other stages.")
+{
+    GIVEN("A stream that filters and transforms ranges before encoding them.")
+    {
+        write_mock writer;
+        auto       s = writer | stream::cobs_encode_write<uint8_t, 8>() |
+                 stream::transform_write([](int v) { return v - 1; }) |
+                 stream::filter_write([](int v) { return v != 0x7F; });
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(writer, write_(vector{3, 0x11, 0x22, 2, 0x33, 0}));
+            array a{0x12, 0x7F, 0x23, 1, 0x34};
+            auto  sender = s.write(a);
+
+            test_sync_submit(writer.range_sender_, sender);
+        }
+    }
+
+    GIVEN("A stream that transforms decoded frames.")
+    {
+        read_mock reader;
+        auto      s = reader | stream::cobs_decode_read() |
+                 stream::transform_read(offset_kernel<int>{1});
+
+        vector<int> wire{3, 0x11, 0x22, 2, 0x33, 0};
+        size_t      i = 0;
+        ALLOW_CALL(reader, read()).LR_RETURN(reader.sender_);
+        ALLOW_CALL(reader.sender_, submit()).LR_RETURN(wire[i++]);
+
+        WHEN("A frame is read.")
+        {
+            array a{0, 0, 0, 0};
+            auto  sender = s.read(a);
+            sender.submit();
+
+            THEN("The decoded values are transformed.")
+            {
+                REQUIRE(i == wire.size());
+                REQUIRE_THAT(a, Equals(array{0x12, 0x23, 1, 0x34}));
+            }
+        }
+    }
+}
+
+SCENARIO("Pipe operator")
+{
+    read_mock  reader;
+    write_mock writer;
+    reader | stream::cobs_decode_read();
+    reader | stream::slip_decode_read();
+    writer | stream::cobs_encode_write<uint8_t, 16>();
+    writer | stream::slip_encode_write<uint8_t, 16>();
+}
@@ -0,0 +1,258 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_FUSED_HPP_
+#define LIBSTREAM_FUSED_HPP_
+
+#include <liboutput_view/filter.hpp>
+#include <liboutput_view/transform.hpp>
+#include <libstream/callback.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/detail/context.hpp>
+
+#include <experimental/ranges/range>
+
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+template<class F> struct transform_op
+{
+    F func_;
+
+    template<class V>
+    using result_t = std::decay_t<std::invoke_result_t<const F&, V>>;
+
+    template<class V, class Next> bool apply(V&& v, Next&& next) const
+    {
+        return next(func_(std::forward<V>(v)));
+    }
+
+    template<class R> auto view(R&& r) const
+    {
+        return output_view::transform(std::forward<R>(r), func_);
+    }
+};
+
+template<class P> struct filter_op
+{
+    P predicate_;
+
+    template<class V> using result_t = std::decay_t<V>;
+
+    template<class V, class Next> bool apply(V&& v, Next&& next) const
+    {
+        return predicate_(v) && next(std::forward<V>(v));
+    }
+
+    template<class R> auto view(R&& r) const
+    {
+        return output_view::filter(std::forward<R>(r), predicate_);
+    }
+};
+
+template<class V, class Ops> struct fused_result;
+
+template<class V> struct fused_result<V, std::tuple<>>
+{
+    using type = V;
+};
+
+template<class V, class Op, class... Ops>
+struct fused_result<V, std::tuple<Op, Ops...>>
+{
+    using type = typename fused_result<typename Op::template result_t<V>,
+                                       std::tuple<Ops...>>::type;
+};
+
+/*!
+ * Passes v through all stages starting at I and hands the result to sink.
+ * Returns false if a stage rejected the value.
+ */
+template<std::size_t I, class Ops, class V, class Sink>
+bool apply_ops(const Ops& ops, V&& v, Sink& sink)
+{
+    if constexpr(I == std::tuple_size_v<Ops>)
+    {
+        sink(std::forward<V>(v));
+        return true;
+    }
+    else
+    {
+        return std::get<I>(ops).apply(std::forward<V>(v), [&](auto&& u) {
+            return apply_ops<I + 1>(ops, std::forward<decltype(u)>(u), sink);
+        });
+    }
+}
+
+/*!
+ * Wraps the output range in the views of all stages. The first stage sees
+ * the values of the child first, so its view is the outermost one.
+ */
+template<std::size_t I, class Ops, class R>
+decltype(auto) wrap_view(const Ops& ops, R& r)
+{
+    if constexpr(I == std::tuple_size_v<Ops>) { return (r); }
+    else
+    {
+        return std::get<I>(ops).view(wrap_view<I + 1>(ops, r));
+    }
+}
+
+template<class C, class Ops> class fused_read_context
+{
+    using child_value_type = decltype(std::declval<C>().submit());
+
+  public:
+    using value_type = typename fused_result<child_value_type, Ops>::type;
+
+  private:
+    C                      child_;
+    const Ops&             ops_;
+    read_token<value_type> token_;
+    trampoline             trampoline_;
+    LIBSTREAM_TRACE_TOKEN(read_token<value_type>)
+
+    void submit_internal()
+    {
+        using this_t = fused_read_context<C, Ops>;
+        child_.submit(read_token<child_value_type>{
+            token_.error, token_.cancelled,
+            read_done_token<child_value_type>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    void done_handler(child_value_type v)
+    {
+        auto sink = [this](auto&& r) { token_.done(r); };
+        if(!apply_ops<0>(ops_, v, sink))
+        {
+            trampoline_.run([this] { submit_internal(); });
+        }
+    }
+
+  public:
+    fused_read_context(C&& c, const Ops& ops)
+        : child_(std::forward<C>(c)), ops_(ops)
+    {
+    }
+
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("fused_read")
+        std::optional<value_type> result;
+        auto                      sink = [&result](auto&& r) { result = r; };
+        while(!apply_ops<0>(ops_, child_.submit(), sink)) {}
+        return *result;
+    }
+
+    void submit(read_token<value_type>&& t)
+    {
+        token_ = LIBSTREAM_TRACE_WRAP("fused_read", std::move(t));
+        trampoline_.run([this] { submit_internal(); });
+    }
+
+    void cancel() { child_.cancel(); }
+};
+
+template<class C, class Ops>
+fused_read_context(C&& c, const Ops& ops)->fused_read_context<C, Ops>;
+} // namespace detail
+
+/*!
+ * Chain of transform_read and filter_read stages executed by one context.
+ *
+ * Every completion of the child runs through all stages in a single callback
+ * and only one token is stored per operation, regardless of the number of
+ * stages.
+ */
+template<ReadStreamable S, class Ops> class fused_read_fn
+{
+    S   stream_;
+    Ops ops_;
+
+  public:
+    fused_read_fn(S&& stream, Ops ops)
+        : stream_(std::forward<S>(stream)), ops_(std::move(ops))
+    {
+    }
+
+    auto read() const requires PureReadStreamable<S>
+    {
+        return detail::fused_read_context{stream_.read(), ops_};
+    }
+
+    template<std::experimental::ranges::Range R>
+    auto read(R&& r) const requires PureReadStreamable<S>
+    {
+        return detail::base_range_context{
+            stream_.read(detail::wrap_view<0>(ops_, r))};
+    }
+
+    template<class V>
+    auto readwrite(V&& v) const requires ReadWriteStreamable<S>
+    {
+        return detail::fused_read_context{
+            stream_.readwrite(std::forward<V>(v)), ops_};
+    }
+
+    template<std::experimental::ranges::InputRange Rin,
+             std::experimental::ranges::Range      Rout>
+    auto readwrite(Rin&& rin, Rout& rout) const requires ReadWriteStreamable<S>
+    {
+        return detail::base_range_context{stream_.readwrite(
+            std::forward<Rin>(rin), detail::wrap_view<0>(ops_, rout))};
+    }
+
+    template<class MoreOps> auto fuse(MoreOps more) &&
+    {
+        using ops_t = decltype(std::tuple_cat(ops_, std::move(more)));
+        return fused_read_fn<S, ops_t>{std::forward<S>(stream_),
+                                       std::tuple_cat(std::move(ops_),
+                                                      std::move(more))};
+    }
+};
+
+template<ReadStreamable S, class Ops>
+fused_read_fn(S&, Ops)->fused_read_fn<S&, Ops>;
+template<ReadStreamable S, class Ops>
+fused_read_fn(S&&, Ops)->fused_read_fn<S, Ops>;
+
+template<class Ops> class fused_read_pipe
+{
+    Ops ops_;
+
+  public:
+    fused_read_pipe(Ops ops) : ops_(std::move(ops)) {}
+
+    template<ReadStreamable S> ReadStreamable pipe(S&& s) const
+    {
+        return fused_read_fn<S, Ops>{std::forward<S>(s), ops_};
+    }
+
+    Ops read_ops() const { return ops_; }
+};
+
+template<FusableReadPipe P1, FusableReadPipe P2>
+Pipeable operator|(P1&& p1, P2&& p2)
+{
+    return fused_read_pipe{std::tuple_cat(p1.read_ops(), p2.read_ops())};
+}
+
+template<ReadStreamable S, class Ops, FusableReadPipe P>
+ReadStreamable operator|(fused_read_fn<S, Ops>&& stream, const P& pipe)
+{
+    return std::move(stream).fuse(pipe.read_ops());
+}
+} // namespace stream
+
+#endif /* LIBSTREAM_FUSED_HPP_ */
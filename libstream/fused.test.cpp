@@ -0,0 +1,172 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/fused.hpp>
+
+#include <libstream/filter.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/constrained_types.hpp>
+#include <tests/helpers/range_matcher.hpp>
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/readwritestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <type_traits>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+template<class T> struct is_fused : std::false_type
+{
+};
+template<class S, class Ops>
+struct is_fused<fused_read_fn<S, Ops>> : std::true_type
+{
+};
+
+SCENARIO("Fusing read stages.")
+{
+    auto p = stream::transform_read([](auto v) { return v + 1; }) |
+             stream::filter_read([](auto v) { return v != 1; }) |
+             stream::transform_read([](auto v) { return v * 2; });
+
+    GIVEN("A read stream with the fused pipe applied.")
+    {
+        read_mock reader;
+        auto      s = reader | p;
+
+        THEN("All stages are collapsed into one adaptor.")
+        {
+            REQUIRE(is_fused<decltype(s)>::value);
+        }
+
+        WHEN("A single value is read.")
+        {
+            REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+            auto sender = s.read();
+
+            WHEN("Synchronous submit is called.")
+            {
+                int i = 0;
+                REQUIRE_CALL(reader.sender_, submit())
+                    .LR_RETURN(i)
+                    .LR_SIDE_EFFECT(++i);
+                REQUIRE_CALL(reader.sender_, submit()).LR_RETURN(i);
+                REQUIRE(sender.submit() == 4);
+            }
+
+            WHEN("Asynchronous submit is called.")
+            {
+                read_token<int> t;
+                REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                    .LR_SIDE_EFFECT(t = _1);
+                read_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+
+                sender.submit(
+                    read_token<int>{error_mock, cancel_mock, callback_mock});
+
+                WHEN("A rejected value is read.")
+                {
+                    REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                        .LR_SIDE_EFFECT(t = _1);
+                    t.done(0);
+
+                    WHEN("An accepted value is read.")
+                    {
+                        REQUIRE_CALL(callback_mock, call(6));
+                        t.done(2);
+                    }
+                }
+
+                WHEN("The error callback is invoked.")
+                {
+                    REQUIRE_CALL(error_mock, call(dummy_error));
+                    t.error(dummy_error);
+                }
+
+                WHEN("The operation is cancelled.")
+                {
+                    REQUIRE_CALL(reader.sender_, cancel());
+                    sender.cancel();
+
+                    REQUIRE_CALL(cancel_mock, call());
+                    t.cancelled();
+                }
+            }
+        }
+
+        WHEN("A range is read.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 0, 2});
+            array a{0, 0};
+            auto  sender = s.read(a);
+            REQUIRE_THAT(a, Equals(array{4, 6}));
+
+            test_sync_submit(reader.range_sender_, sender);
+            test_async_range_submit(reader.range_sender_, sender);
+            test_async_range_submit(reader.range_sender_, sender, dummy_error);
+        }
+    }
+
+    GIVEN("A read-write stream with the fused pipe applied.")
+    {
+        read_write_mock readwriter;
+        auto            s = readwriter | p;
+
+        WHEN("A single value is read.")
+        {
+            REQUIRE_CALL(readwriter, readwrite(5))
+                .LR_RETURN(readwriter.sender_);
+            auto sender = s.readwrite(5);
+
+            test_sync_read_submit(readwriter.sender_, sender,
+                                  test_pair{1, 4});
+            test_async_read_submit(readwriter.sender_, sender,
+                                   test_pair{1, 4});
+        }
+
+        WHEN("A range is read.")
+        {
+            REQUIRE_CALL(readwriter, readwrite_(vector{1, 2}, _))
+                .SIDE_EFFECT(_2 = vector{0, 1, 2});
+            array a_read{0, 0};
+            array a_write{1, 2};
+            auto  sender = s.readwrite(a_write, a_read);
+            REQUIRE_THAT(a_read, Equals(array{4, 6}));
+
+            test_sync_submit(readwriter.range_sender_, sender);
+        }
+    }
+
+    GIVEN("A fused stream.")
+    {
+        read_mock reader;
+
+        THEN("Further read stages are fused into it.")
+        {
+            auto s = reader | p;
+            auto s2 =
+                std::move(s) | stream::filter_read([](auto v) { return v; });
+            REQUIRE(is_fused<decltype(s2)>::value);
+        }
+    }
+}
+
+SCENARIO("R-value reader with fused stages.")
+{
+    [[maybe_unused]] auto s =
+        move_only_reader{} |
+        (stream::transform_read([](int v) { return v + 1; }) |
+         stream::filter_read([](int v) { return v != 0; }));
+}
@@ -0,0 +1,182 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_IO_BUFFER_HPP_
+#define LIBSTREAM_IO_BUFFER_HPP_
+
+#include <experimental/ranges/range>
+
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Remainder of size bytes at data, of which offset bytes have already been
+ * transferred. All buffers describe their remainder as an array of at most
+ * max_segments iovecs, so the file descriptor streams only issue vectored
+ * system calls.
+ */
+inline iovec make_iovec(const void* data, std::size_t offset, std::size_t size)
+{
+    return {const_cast<std::byte*>(static_cast<const std::byte*>(data)) +
+                offset,
+            size - offset};
+}
+
+/*!
+ * Bytes of a single value transferred by a file descriptor stream.
+ */
+template<class T> struct io_value_buffer
+{
+    static constexpr std::size_t max_segments = 1;
+
+    T           value_;
+    std::size_t transferred_ = 0;
+
+    void        rewind() { transferred_ = 0; }
+    bool        complete() const { return transferred_ == sizeof(T); }
+    void        advance(std::size_t n) { transferred_ += n; }
+    std::size_t fill(iovec* iov)
+    {
+        iov[0] = make_iovec(&value_, transferred_, sizeof(T));
+        return 1;
+    }
+};
+
+/*!
+ * Bytes of a contiguous range transferred by a file descriptor stream.
+ */
+struct io_range_buffer
+{
+    static constexpr std::size_t max_segments = 1;
+
+    void*       data_;
+    std::size_t size_;
+    std::size_t transferred_ = 0;
+
+    void        rewind() { transferred_ = 0; }
+    bool        complete() const { return transferred_ == size_; }
+    void        advance(std::size_t n) { transferred_ += n; }
+    std::size_t fill(iovec* iov)
+    {
+        iov[0] = make_iovec(data_, transferred_, size_);
+        return 1;
+    }
+};
+
+template<std::experimental::ranges::ContiguousRange R>
+io_range_buffer make_io_buffer(R& r)
+{
+    namespace ranges = std::experimental::ranges;
+    using value_type = std::remove_reference_t<decltype(*ranges::data(r))>;
+    static_assert(std::is_trivially_copyable_v<value_type>,
+                  "Only trivially copyable types can be transferred.");
+    return {const_cast<std::remove_const_t<value_type>*>(ranges::data(r)),
+            ranges::size(r) * sizeof(value_type)};
+}
+
+/*!
+ * Bytes of a range of contiguous segments transferred by a file descriptor
+ * stream. Up to max_segments segments are handed to a single system call,
+ * empty segments are skipped.
+ */
+template<class R> class io_segment_buffer
+{
+    using iterator = std::experimental::ranges::iterator_t<
+        std::remove_reference_t<R>>;
+
+    R           segments_;
+    iterator    current_{};
+    std::size_t offset_ = 0;
+
+    template<class Segment> static std::size_t bytes(Segment&& s)
+    {
+        namespace ranges = std::experimental::ranges;
+        using value_type = std::remove_reference_t<decltype(*ranges::data(s))>;
+        static_assert(std::is_trivially_copyable_v<value_type>,
+                      "Only trivially copyable types can be transferred.");
+        return ranges::size(s) * sizeof(value_type);
+    }
+
+    void skip_empty()
+    {
+        while(current_ != std::experimental::ranges::end(segments_) &&
+              bytes(*current_) == 0)
+        {
+            ++current_;
+        }
+    }
+
+  public:
+    static constexpr std::size_t max_segments = 16;
+
+    explicit io_segment_buffer(R&& segments)
+        : segments_(std::forward<R>(segments))
+    {
+    }
+
+    void rewind()
+    {
+        current_ = std::experimental::ranges::begin(segments_);
+        offset_  = 0;
+        skip_empty();
+    }
+
+    bool complete()
+    {
+        return current_ == std::experimental::ranges::end(segments_);
+    }
+
+    void advance(std::size_t n)
+    {
+        while(n > 0)
+        {
+            auto left = bytes(*current_) - offset_;
+            if(n < left)
+            {
+                offset_ += n;
+                return;
+            }
+            n -= left;
+            offset_ = 0;
+            ++current_;
+            skip_empty();
+        }
+    }
+
+    std::size_t fill(iovec* iov)
+    {
+        namespace ranges   = std::experimental::ranges;
+        std::size_t count  = 0;
+        std::size_t offset = offset_;
+        for(auto i = current_;
+            i != ranges::end(segments_) && count < max_segments; ++i)
+        {
+            auto&& s    = *i;
+            auto   size = bytes(s);
+            if(size == 0) { continue; }
+            iov[count++] = make_iovec(ranges::data(s), offset, size);
+            offset       = 0;
+        }
+        return count;
+    }
+};
+
+template<class R> io_segment_buffer<R> make_io_segments(R&& segments)
+{
+    return io_segment_buffer<R>{std::forward<R>(segments)};
+}
+} // namespace detail
+} // namespace stream
+
+#endif // LIBSTREAM_IO_BUFFER_HPP_
@@ -0,0 +1,414 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_IO_EPOLL_HPP_
+#define LIBSTREAM_IO_EPOLL_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/io/buffer.hpp>
+
+#include <experimental/ranges/range>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+struct epoll_operation
+{
+    /*!
+     * Attempts the transfer. Returns false if the file descriptor would
+     * block.
+     */
+    bool (*perform_)(epoll_operation*) = nullptr;
+};
+
+class epoll_handle;
+} // namespace detail
+
+/*!
+ * Readiness based event loop.
+ *
+ * run_once() waits for readiness of the registered file descriptors and
+ * continues the pending operations on them on the calling thread. The
+ * reactor is not thread-safe.
+ */
+class epoll_reactor
+{
+    int        fd_;
+    error_code error_ = 0;
+
+  public:
+    epoll_reactor() : fd_(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        if(fd_ < 0) { error_ = errno; }
+    }
+
+    epoll_reactor(const epoll_reactor&) = delete;
+    epoll_reactor& operator=(const epoll_reactor&) = delete;
+
+    ~epoll_reactor()
+    {
+        if(fd_ >= 0) { ::close(fd_); }
+    }
+
+    /*!
+     * errno of the creation of the epoll instance, 0 if it is usable.
+     */
+    error_code error() const noexcept { return error_; }
+
+    int native_handle() const noexcept { return fd_; }
+
+    /*!
+     * Waits at most timeout milliseconds, -1 waits forever, and continues all
+     * operations whose file descriptor became ready. Returns the number of
+     * ready file descriptors.
+     */
+    std::size_t run_once(int timeout = -1);
+};
+
+namespace detail
+{
+/*!
+ * Registration of one file descriptor. At most one read and one write can be
+ * pending at a time, the interest set is only updated when it changes.
+ */
+class epoll_handle
+{
+    epoll_reactor&   reactor_;
+    int              fd_;
+    epoll_operation* reader_     = nullptr;
+    epoll_operation* writer_     = nullptr;
+    std::uint32_t    interest_   = 0;
+    bool             registered_ = false;
+
+    error_code update()
+    {
+        std::uint32_t interest = (reader_ != nullptr ? EPOLLIN : 0u) |
+                                 (writer_ != nullptr ? EPOLLOUT : 0u);
+        if(interest == interest_ && registered_) { return 0; }
+
+        // An fd with an empty interest set still reports EPOLLHUP and
+        // EPOLLERR, so it is removed until the next wait.
+        if(interest == 0)
+        {
+            if(registered_)
+            {
+                ::epoll_ctl(reactor_.native_handle(), EPOLL_CTL_DEL, fd_,
+                            nullptr);
+                registered_ = false;
+            }
+            interest_ = 0;
+            return 0;
+        }
+
+        epoll_event event{};
+        event.events   = interest;
+        event.data.ptr = this;
+        int op         = registered_ ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+        if(::epoll_ctl(reactor_.native_handle(), op, fd_, &event) < 0)
+        {
+            return errno;
+        }
+        registered_ = true;
+        interest_   = interest;
+        return 0;
+    }
+
+    void resume(epoll_operation*& slot)
+    {
+        auto* op = slot;
+        slot     = nullptr;
+        if(!op->perform_(op))
+        {
+            slot = op;
+            return;
+        }
+        update();
+    }
+
+  public:
+    epoll_handle(epoll_reactor& reactor, int fd) : reactor_(reactor), fd_(fd)
+    {
+        int flags = ::fcntl(fd_, F_GETFL);
+        if(flags >= 0) { ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK); }
+    }
+
+    epoll_handle(const epoll_handle&) = delete;
+    epoll_handle& operator=(const epoll_handle&) = delete;
+
+    ~epoll_handle()
+    {
+        if(registered_)
+        {
+            ::epoll_ctl(reactor_.native_handle(), EPOLL_CTL_DEL, fd_, nullptr);
+        }
+    }
+
+    int fd() const noexcept { return fd_; }
+
+    error_code wait_readable(epoll_operation& op)
+    {
+        reader_ = &op;
+        return update();
+    }
+
+    error_code wait_writable(epoll_operation& op)
+    {
+        writer_ = &op;
+        return update();
+    }
+
+    /*!
+     * Removes op. Returns false if op was not pending.
+     */
+    bool remove(epoll_operation& op)
+    {
+        if(reader_ == &op) { reader_ = nullptr; }
+        else if(writer_ == &op)
+        {
+            writer_ = nullptr;
+        }
+        else
+        {
+            return false;
+        }
+        update();
+        return true;
+    }
+
+    /*!
+     * Continues the pending operations. Errors and hang-ups are detected by
+     * the operations themselves when they retry the transfer.
+     */
+    void ready(std::uint32_t events)
+    {
+        if(reader_ != nullptr && (events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+        {
+            resume(reader_);
+        }
+        if(writer_ != nullptr && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+        {
+            resume(writer_);
+        }
+    }
+};
+
+/*!
+ * Transfers the whole buffer with non-blocking system calls. The transfer is
+ * attempted immediately and only waits for readiness if the file descriptor
+ * would block. Reaching the end of the file before the buffer is filled
+ * completes with ENODATA.
+ */
+template<class Token, class Buffer, bool Read>
+class epoll_context : epoll_operation
+{
+    using this_t = epoll_context<Token, Buffer, Read>;
+
+    epoll_handle&                           handle_;
+    Buffer                                  buffer_;
+    std::array<iovec, Buffer::max_segments> iov_;
+    Token                                   token_;
+
+    ssize_t transfer()
+    {
+        auto    count = static_cast<int>(buffer_.fill(iov_.data()));
+        ssize_t n;
+        do
+        {
+            n = Read ? ::readv(handle_.fd(), iov_.data(), count)
+                     : ::writev(handle_.fd(), iov_.data(), count);
+        } while(n < 0 && errno == EINTR);
+        return n;
+    }
+
+    void report()
+    {
+        if constexpr(std::is_same_v<Token, base_token>) { token_.done(); }
+        else
+        {
+            token_.done(buffer_.value_);
+        }
+    }
+
+    /*
+     * Returns false if the file descriptor would block, otherwise the token
+     * has been invoked.
+     */
+    static bool perform_handler(epoll_operation* op)
+    {
+        auto& self = *static_cast<this_t*>(op);
+        while(!self.buffer_.complete())
+        {
+            auto n = self.transfer();
+            if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                return false;
+            }
+            if(n < 0)
+            {
+                self.token_.error(errno);
+                return true;
+            }
+            if(n == 0)
+            {
+                self.token_.error(
+                    static_cast<error_code>(std::errc::no_message_available));
+                return true;
+            }
+            self.buffer_.advance(static_cast<std::size_t>(n));
+        }
+        self.report();
+        return true;
+    }
+
+  public:
+    epoll_context(epoll_handle& handle, Buffer buffer)
+        : epoll_operation{&this_t::perform_handler}, handle_(handle),
+          buffer_(std::move(buffer))
+    {
+    }
+
+    /*!
+     * Blocks in poll(2) whenever the file descriptor is not ready.
+     */
+    auto submit()
+    {
+        pollfd p{handle_.fd(), Read ? POLLIN : POLLOUT, 0};
+        for(buffer_.rewind(); !buffer_.complete();)
+        {
+            auto n = transfer();
+            if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                ::poll(&p, 1, -1);
+                continue;
+            }
+            if(n <= 0) { break; }
+            buffer_.advance(static_cast<std::size_t>(n));
+        }
+        if constexpr(!std::is_same_v<Token, base_token>)
+        {
+            return buffer_.value_;
+        }
+    }
+
+    void submit(Token&& t)
+    {
+        token_ = t;
+        buffer_.rewind();
+        if(perform_handler(this)) { return; }
+
+        error_code e =
+            Read ? handle_.wait_readable(*this) : handle_.wait_writable(*this);
+        if(e != 0)
+        {
+            handle_.remove(*this);
+            token_.error(e);
+        }
+    }
+
+    void cancel()
+    {
+        if(handle_.remove(*this)) { token_.cancelled(); }
+    }
+};
+} // namespace detail
+
+inline std::size_t epoll_reactor::run_once(int timeout)
+{
+    std::array<epoll_event, 64> events;
+    int                         n;
+    do
+    {
+        n = ::epoll_wait(fd_, events.data(), events.size(), timeout);
+    } while(n < 0 && errno == EINTR);
+
+    for(int i = 0; i < n; ++i)
+    {
+        static_cast<detail::epoll_handle*>(events[i].data.ptr)
+            ->ready(events[i].events);
+    }
+    return n < 0 ? 0 : static_cast<std::size_t>(n);
+}
+
+/*!
+ * Stream of T on a file descriptor, driven by an epoll_reactor.
+ *
+ * The file descriptor is switched to non-blocking mode, but not owned by the
+ * stream. Operations complete inline if the file descriptor is ready,
+ * otherwise from epoll_reactor::run_once(). Works with pipes, sockets,
+ * terminals and every other file descriptor epoll supports.
+ */
+template<class T = std::byte> class fd_stream
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be transferred.");
+
+    mutable detail::epoll_handle handle_;
+
+  public:
+    fd_stream(epoll_reactor& reactor, int fd) : handle_(reactor, fd) {}
+
+    int native_handle() const noexcept { return handle_.fd(); }
+
+    auto read() const
+    {
+        return detail::epoll_context<read_token<T>,
+                                     detail::io_value_buffer<T>, true>{
+            handle_, {}};
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    auto read(R&& r) const
+    {
+        return detail::epoll_context<base_token, detail::io_range_buffer,
+                                     true>{handle_, detail::make_io_buffer(r)};
+    }
+
+    auto write(const T& v) const
+    {
+        return detail::epoll_context<base_token, detail::io_value_buffer<T>,
+                                     false>{handle_, {v}};
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    auto write(R&& r) const
+    {
+        return detail::epoll_context<base_token, detail::io_range_buffer,
+                                     false>{handle_,
+                                            detail::make_io_buffer(r)};
+    }
+
+    /*!
+     * Writes a range of contiguous segments with writev(2), up to 16 segments
+     * per system call.
+     */
+    template<std::experimental::ranges::ForwardRange R>
+    auto writev(R&& segments) const
+    {
+        return detail::epoll_context<base_token, detail::io_segment_buffer<R>,
+                                     false>{
+            handle_, detail::make_io_segments(std::forward<R>(segments))};
+    }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_IO_EPOLL_HPP_
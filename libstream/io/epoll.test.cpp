@@ -0,0 +1,247 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/io/epoll.hpp>
+
+#include <libstream/filter.hpp>
+#include <libstream/span.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/mocks/callback.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+
+namespace
+{
+struct fd_pair
+{
+    int fds_[2];
+
+    explicit fd_pair(bool socket)
+    {
+        REQUIRE((socket ? ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds_)
+                        : ::pipe(fds_)) == 0);
+    }
+    ~fd_pair()
+    {
+        ::close(fds_[0]);
+        ::close(fds_[1]);
+    }
+};
+
+void run_until(epoll_reactor& reactor, bool& flag)
+{
+    while(!flag) { reactor.run_once(1000); }
+}
+} // namespace
+
+SCENARIO("fd streams on a pipe.")
+{
+    epoll_reactor reactor;
+    REQUIRE(reactor.error() == 0);
+
+    GIVEN("Streams on both ends of a pipe.")
+    {
+        fd_pair         p{false};
+        fd_stream<char> in{reactor, p.fds_[0]};
+        fd_stream<char> out{reactor, p.fds_[1]};
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        done_callback_mock   read_done, write_done;
+        read_callback_mock   value_mock;
+
+        WHEN("A range is read before it is written in two parts.")
+        {
+            array<char, 5> buffer{};
+            auto           reader = in.read(buffer);
+            reader.submit(base_token{error_mock, cancel_mock, read_done});
+            REQUIRE(reactor.run_once(0) == 0);
+
+            array<char, 3> first{'a', 'b', 'c'};
+            array<char, 2> second{'d', 'e'};
+            auto           writer1 = out.write(first);
+            auto           writer2 = out.write(second);
+
+            THEN("The writes complete inline and the read from the reactor.")
+            {
+                REQUIRE_CALL(write_done, call()).TIMES(2);
+                writer1.submit(base_token{error_mock, cancel_mock, write_done});
+                writer2.submit(base_token{error_mock, cancel_mock, write_done});
+
+                bool finished = false;
+                REQUIRE_CALL(read_done, call()).LR_SIDE_EFFECT(finished = true);
+                run_until(reactor, finished);
+                REQUIRE(buffer == array{'a', 'b', 'c', 'd', 'e'});
+            }
+        }
+
+        WHEN("More is written than the pipe can hold.")
+        {
+            vector<char> data(1 << 20, 'x');
+            vector<char> received(data.size());
+            auto         writer = out.write(data);
+            auto         reader = in.read(received);
+
+            THEN("The write waits for readiness until everything is read.")
+            {
+                bool written = false, read = false;
+                REQUIRE_CALL(write_done, call()).LR_SIDE_EFFECT(written = true);
+                REQUIRE_CALL(read_done, call()).LR_SIDE_EFFECT(read = true);
+                writer.submit(base_token{error_mock, cancel_mock, write_done});
+                REQUIRE(!written);
+                reader.submit(base_token{error_mock, cancel_mock, read_done});
+                run_until(reactor, written);
+                run_until(reactor, read);
+                REQUIRE(received == data);
+            }
+        }
+
+        WHEN("A pending read is cancelled.")
+        {
+            auto reader = in.read();
+            reader.submit(
+                read_token<char>{error_mock, cancel_mock, value_mock});
+
+            REQUIRE_CALL(cancel_mock, call());
+            reader.cancel();
+            REQUIRE(reactor.run_once(0) == 0);
+        }
+
+        WHEN("The write end is closed while a read is pending.")
+        {
+            auto reader = in.read();
+            reader.submit(
+                read_token<char>{error_mock, cancel_mock, value_mock});
+            ::close(p.fds_[1]);
+            p.fds_[1] = ::dup(p.fds_[0]);
+
+            THEN("The read fails with ENODATA.")
+            {
+                bool finished = false;
+                REQUIRE_CALL(error_mock, call(ENODATA))
+                    .LR_SIDE_EFFECT(finished = true);
+                run_until(reactor, finished);
+            }
+
+            THEN("The hung up pipe does not wake the reactor afterwards.")
+            {
+                bool finished = false;
+                REQUIRE_CALL(error_mock, call(ENODATA))
+                    .LR_SIDE_EFFECT(finished = true);
+                run_until(reactor, finished);
+
+                auto start = chrono::steady_clock::now();
+                REQUIRE(reactor.run_once(100) == 0);
+                REQUIRE(chrono::steady_clock::now() - start >=
+                        chrono::milliseconds(90));
+            }
+        }
+
+        WHEN("Values are written synchronously through an adaptor.")
+        {
+            auto s = out | transform_write([](char c) { return c + 1; });
+            s.write('a').submit();
+            s.write('b').submit();
+
+            THEN("They are read back synchronously.")
+            {
+                REQUIRE(in.read().submit() == 'b');
+                REQUIRE(in.read().submit() == 'c');
+            }
+        }
+
+        WHEN("Segments are written with a single vectored write.")
+        {
+            string                     hello = "hello ", world = "world";
+            array<span<const char>, 3> segments{
+                span<const char>{hello.data(), hello.size()},
+                span<const char>{},
+                span<const char>{world.data(), world.size()}};
+
+            REQUIRE_CALL(write_done, call());
+            out.writev(segments).submit(
+                base_token{error_mock, cancel_mock, write_done});
+
+            THEN("The concatenation of the segments is read back.")
+            {
+                array<char, 11> buffer{};
+                in.read(buffer).submit();
+                REQUIRE(string(buffer.begin(), buffer.end()) == "hello world");
+            }
+        }
+
+        WHEN("A filtered range is written.")
+        {
+            vector<char> data(1 << 20, 'x');
+            for(size_t i = 0; i < data.size(); i += 1000) { data[i] = '-'; }
+            auto s = filter_write(out, [](char c) { return c != '-'; });
+
+            vector<char> received(data.size() - (data.size() + 999) / 1000);
+            auto         writer = s.write(data);
+            auto         reader = in.read(received);
+
+            THEN("The runs between filtered elements are written as segments.")
+            {
+                bool written = false, read = false;
+                REQUIRE_CALL(write_done, call()).LR_SIDE_EFFECT(written = true);
+                REQUIRE_CALL(read_done, call()).LR_SIDE_EFFECT(read = true);
+                writer.submit(base_token{error_mock, cancel_mock, write_done});
+                reader.submit(base_token{error_mock, cancel_mock, read_done});
+                run_until(reactor, written);
+                run_until(reactor, read);
+                REQUIRE(received == vector<char>(received.size(), 'x'));
+            }
+        }
+    }
+}
+
+SCENARIO("fd streams on a socket pair.")
+{
+    epoll_reactor reactor;
+    REQUIRE(reactor.error() == 0);
+
+    GIVEN("Integer streams on both sockets.")
+    {
+        fd_pair        p{true};
+        fd_stream<int> a{reactor, p.fds_[0]};
+        fd_stream<int> b{reactor, p.fds_[1]};
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_callback_mock   value_mock;
+
+        WHEN("Both directions are read at the same time.")
+        {
+            auto read_a = a.read();
+            auto read_b = b.read();
+            read_a.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+            read_b.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+
+            THEN("Each read receives the value sent by the other side.")
+            {
+                int count = 0;
+                REQUIRE_CALL(value_mock, call(1)).LR_SIDE_EFFECT(++count);
+                REQUIRE_CALL(value_mock, call(2)).LR_SIDE_EFFECT(++count);
+                a.write(2).submit();
+                b.write(1).submit();
+                while(count < 2) { reactor.run_once(1000); }
+            }
+        }
+    }
+}
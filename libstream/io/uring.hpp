@@ -0,0 +1,474 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_IO_URING_HPP_
+#define LIBSTREAM_IO_URING_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/io/buffer.hpp>
+
+#include <experimental/ranges/range>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+struct uring_operation
+{
+    void (*complete_)(uring_operation*, std::int32_t) = nullptr;
+    uring_operation* next_cancel_                     = nullptr;
+};
+} // namespace detail
+
+/*!
+ * Submission and completion queue of an io_uring instance.
+ *
+ * Operations only fill submission queue entries. They are handed to the
+ * kernel in one system call by run_once(), or earlier if the submission
+ * queue is full. run_once() then reaps all available completions and
+ * invokes the tokens of the operations on the calling thread. The ring is
+ * not thread-safe.
+ */
+class io_uring_context
+{
+    int        fd_    = -1;
+    error_code error_ = 0;
+
+    void*         sq_ring_      = nullptr;
+    std::size_t   sq_ring_size_ = 0;
+    void*         cq_ring_      = nullptr;
+    std::size_t   cq_ring_size_ = 0;
+    io_uring_sqe* sqes_         = nullptr;
+    std::size_t   sqes_size_    = 0;
+
+    std::atomic<unsigned>* sq_head_       = nullptr;
+    std::atomic<unsigned>* sq_tail_       = nullptr;
+    unsigned               sq_mask_       = 0;
+    unsigned*              sq_array_      = nullptr;
+    unsigned               sq_entries_    = 0;
+    unsigned               sq_local_tail_ = 0;
+    unsigned               to_submit_     = 0;
+
+    std::atomic<unsigned>* cq_head_ = nullptr;
+    std::atomic<unsigned>* cq_tail_ = nullptr;
+    unsigned               cq_mask_ = 0;
+    io_uring_cqe*          cqes_    = nullptr;
+
+    // Cancellations which found no free submission queue entry.
+    detail::uring_operation* cancels_ = nullptr;
+
+    void forget_cancel(detail::uring_operation& op)
+    {
+        auto** link = &cancels_;
+        while(*link != nullptr && *link != &op)
+        {
+            link = &(*link)->next_cancel_;
+        }
+        if(*link != nullptr)
+        {
+            *link           = op.next_cancel_;
+            op.next_cancel_ = nullptr;
+        }
+    }
+
+    template<class T> static T* at(void* base, std::uint32_t offset)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    int enter(unsigned submit, unsigned wait)
+    {
+        unsigned flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd_, submit,
+                                          wait, flags, nullptr, 0));
+    }
+
+    int flush(unsigned wait)
+    {
+        sq_tail_->store(sq_local_tail_, std::memory_order_release);
+        int r;
+        do
+        {
+            r = enter(to_submit_, wait);
+        } while(r < 0 && errno == EINTR);
+        if(r > 0) { to_submit_ -= static_cast<unsigned>(r); }
+        return r < 0 ? errno : 0;
+    }
+
+    io_uring_sqe* next_sqe()
+    {
+        if(error_ != 0) { return nullptr; }
+        if(sq_local_tail_ - sq_head_->load(std::memory_order_acquire) ==
+           sq_entries_)
+        {
+            flush(0);
+            if(sq_local_tail_ - sq_head_->load(std::memory_order_acquire) ==
+               sq_entries_)
+            {
+                return nullptr;
+            }
+        }
+        unsigned      index = sq_local_tail_ & sq_mask_;
+        io_uring_sqe* sqe   = &sqes_[index];
+        sq_array_[index]    = index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++sq_local_tail_;
+        ++to_submit_;
+        return sqe;
+    }
+
+  public:
+    explicit io_uring_context(unsigned entries = 64)
+    {
+        io_uring_params p{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if(fd_ < 0)
+        {
+            error_ = errno;
+            return;
+        }
+
+        sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single   = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single)
+        {
+            sq_ring_size_ = cq_ring_size_ =
+                sq_ring_size_ > cq_ring_size_ ? sq_ring_size_ : cq_ring_size_;
+        }
+
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_
+                          : ::mmap(nullptr, cq_ring_size_,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, fd_,
+                                   IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if(sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED ||
+           sqes == MAP_FAILED)
+        {
+            error_ = errno;
+            return;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        sq_head_       = at<std::atomic<unsigned>>(sq_ring_, p.sq_off.head);
+        sq_tail_       = at<std::atomic<unsigned>>(sq_ring_, p.sq_off.tail);
+        sq_mask_       = *at<unsigned>(sq_ring_, p.sq_off.ring_mask);
+        sq_array_      = at<unsigned>(sq_ring_, p.sq_off.array);
+        sq_entries_    = p.sq_entries;
+        sq_local_tail_ = sq_tail_->load(std::memory_order_relaxed);
+
+        cq_head_ = at<std::atomic<unsigned>>(cq_ring_, p.cq_off.head);
+        cq_tail_ = at<std::atomic<unsigned>>(cq_ring_, p.cq_off.tail);
+        cq_mask_ = *at<unsigned>(cq_ring_, p.cq_off.ring_mask);
+        cqes_    = at<io_uring_cqe>(cq_ring_, p.cq_off.cqes);
+    }
+
+    io_uring_context(const io_uring_context&) = delete;
+    io_uring_context& operator=(const io_uring_context&) = delete;
+
+    ~io_uring_context()
+    {
+        if(sqes_ != nullptr) { ::munmap(sqes_, sqes_size_); }
+        if(cq_ring_ != nullptr && cq_ring_ != MAP_FAILED &&
+           cq_ring_ != sq_ring_)
+        {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if(sq_ring_ != nullptr && sq_ring_ != MAP_FAILED)
+        {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if(fd_ >= 0) { ::close(fd_); }
+    }
+
+    /*!
+     * errno of the setup of the ring, 0 if the ring is usable.
+     */
+    error_code error() const noexcept { return error_; }
+
+    /*!
+     * Queues a read or write. For the vectored opcodes data and size are the
+     * iovec array and its length. Returns false if no submission queue entry
+     * is available or the ring is not set up.
+     */
+    bool prepare(std::uint8_t opcode, int fd, void* data, std::size_t size,
+                 detail::uring_operation& op)
+    {
+        io_uring_sqe* sqe = next_sqe();
+        if(sqe == nullptr) { return false; }
+        sqe->opcode    = opcode;
+        sqe->fd        = fd;
+        sqe->off       = static_cast<std::uint64_t>(-1);
+        sqe->addr      = reinterpret_cast<std::uintptr_t>(data);
+        sqe->len       = static_cast<std::uint32_t>(size);
+        sqe->user_data = reinterpret_cast<std::uintptr_t>(&op);
+        return true;
+    }
+
+    /*!
+     * Queues the cancellation of an operation. The operation completes with
+     * ECANCELED if it was still in flight.
+     */
+    bool prepare_cancel(detail::uring_operation& op)
+    {
+        io_uring_sqe* sqe = next_sqe();
+        if(sqe == nullptr) { return false; }
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->fd        = -1;
+        sqe->addr      = reinterpret_cast<std::uintptr_t>(&op);
+        sqe->user_data = 0;
+        return true;
+    }
+
+    /*!
+     * Cancels an operation. If no submission queue entry is available, the
+     * cancellation is queued by the next run_once(), unless the operation
+     * completes before.
+     */
+    void cancel(detail::uring_operation& op)
+    {
+        if(error_ != 0 || prepare_cancel(op)) { return; }
+        for(auto* c = cancels_; c != nullptr; c = c->next_cancel_)
+        {
+            if(c == &op) { return; }
+        }
+        op.next_cancel_ = cancels_;
+        cancels_        = &op;
+    }
+
+    /*!
+     * Submits all queued entries and invokes the tokens of all completed
+     * operations. If wait is set, blocks until at least one operation has
+     * completed. Returns the number of reaped completions.
+     */
+    std::size_t run_once(bool wait = false)
+    {
+        if(error_ != 0) { return 0; }
+
+        while(cancels_ != nullptr && prepare_cancel(*cancels_))
+        {
+            auto* op         = cancels_;
+            cancels_         = op->next_cancel_;
+            op->next_cancel_ = nullptr;
+        }
+        if(to_submit_ > 0 || wait) { flush(wait ? 1 : 0); }
+
+        std::size_t count = 0;
+        unsigned    head  = cq_head_->load(std::memory_order_relaxed);
+        while(head != cq_tail_->load(std::memory_order_acquire))
+        {
+            io_uring_cqe cqe = cqes_[head & cq_mask_];
+            cq_head_->store(++head, std::memory_order_release);
+            if(cqe.user_data == 0) { continue; }
+
+            auto* op = reinterpret_cast<detail::uring_operation*>(
+                static_cast<std::uintptr_t>(cqe.user_data));
+            forget_cancel(*op);
+            ++count;
+            op->complete_(op, cqe.res);
+        }
+        return count;
+    }
+};
+
+namespace detail
+{
+/*!
+ * Transfers the whole buffer. Short reads and writes are resubmitted for
+ * the remainder, reaching the end of the file before the buffer is filled
+ * completes with ENODATA.
+ */
+template<class Token, class Buffer>
+class uring_context : uring_operation
+{
+    using this_t = uring_context<Token, Buffer>;
+
+    io_uring_context&                       ring_;
+    int                                     fd_;
+    std::uint8_t                            opcode_;
+    Buffer                                  buffer_;
+    std::array<iovec, Buffer::max_segments> iov_;
+    Token                                   token_;
+
+    void queue()
+    {
+        auto count = buffer_.fill(iov_.data());
+        if(!ring_.prepare(opcode_, fd_, iov_.data(), count, *this))
+        {
+            token_.error(ring_.error() != 0
+                             ? ring_.error()
+                             : static_cast<error_code>(
+                                   std::errc::resource_unavailable_try_again));
+        }
+    }
+
+    void report()
+    {
+        if constexpr(std::is_same_v<Token, base_token>) { token_.done(); }
+        else
+        {
+            token_.done(buffer_.value_);
+        }
+    }
+
+    static void complete_handler(uring_operation* op, std::int32_t res)
+    {
+        auto& self = *static_cast<this_t*>(op);
+        if(res == -ECANCELED) { self.token_.cancelled(); }
+        else if(res < 0)
+        {
+            self.token_.error(-res);
+        }
+        else if(res == 0)
+        {
+            self.token_.error(
+                static_cast<error_code>(std::errc::no_message_available));
+        }
+        else
+        {
+            self.buffer_.advance(static_cast<std::size_t>(res));
+            if(!self.buffer_.complete()) { self.queue(); }
+            else
+            {
+                self.report();
+            }
+        }
+    }
+
+  public:
+    uring_context(io_uring_context& ring, int fd, std::uint8_t opcode,
+                  Buffer buffer)
+        : uring_operation{&this_t::complete_handler}, ring_(ring), fd_(fd),
+          opcode_(opcode), buffer_(std::move(buffer))
+    {
+    }
+
+    /*!
+     * Blocking transfer without the ring.
+     */
+    auto submit()
+    {
+        for(buffer_.rewind(); !buffer_.complete();)
+        {
+            auto count = static_cast<int>(buffer_.fill(iov_.data()));
+            auto n     = opcode_ == IORING_OP_READV
+                         ? ::readv(fd_, iov_.data(), count)
+                         : ::writev(fd_, iov_.data(), count);
+            if(n < 0 && errno == EINTR) { continue; }
+            if(n <= 0) { break; }
+            buffer_.advance(static_cast<std::size_t>(n));
+        }
+        if constexpr(!std::is_same_v<Token, base_token>)
+        {
+            return buffer_.value_;
+        }
+    }
+
+    void submit(Token&& t)
+    {
+        token_ = t;
+        buffer_.rewind();
+        // An empty transfer would complete with 0 bytes, i.e. ENODATA.
+        if(buffer_.complete())
+        {
+            report();
+            return;
+        }
+        queue();
+    }
+
+    void cancel() { ring_.cancel(*this); }
+};
+} // namespace detail
+
+/*!
+ * Stream of T on a file descriptor, backed by io_uring.
+ *
+ * Reads and writes continue at the current file position, so the same stream
+ * works for regular files, pipes and sockets. The stream does not own the
+ * file descriptor. Asynchronous operations complete from
+ * io_uring_context::run_once().
+ */
+template<class T = std::byte> class io_uring_stream
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Only trivially copyable types can be transferred.");
+
+    io_uring_context& ring_;
+    int               fd_;
+
+  public:
+    io_uring_stream(io_uring_context& ring, int fd) : ring_(ring), fd_(fd) {}
+
+    int native_handle() const noexcept { return fd_; }
+
+    auto read() const
+    {
+        return detail::uring_context<read_token<T>,
+                                     detail::io_value_buffer<T>>{
+            ring_, fd_, IORING_OP_READV, {}};
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    auto read(R&& r) const
+    {
+        return detail::uring_context<base_token, detail::io_range_buffer>{
+            ring_, fd_, IORING_OP_READV, detail::make_io_buffer(r)};
+    }
+
+    auto write(const T& v) const
+    {
+        return detail::uring_context<base_token,
+                                     detail::io_value_buffer<T>>{
+            ring_, fd_, IORING_OP_WRITEV, {v}};
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    auto write(R&& r) const
+    {
+        return detail::uring_context<base_token, detail::io_range_buffer>{
+            ring_, fd_, IORING_OP_WRITEV, detail::make_io_buffer(r)};
+    }
+
+    /*!
+     * Writes a range of contiguous segments, up to 16 segments per
+     * submission queue entry.
+     */
+    template<std::experimental::ranges::ForwardRange R>
+    auto writev(R&& segments) const
+    {
+        return detail::uring_context<base_token,
+                                     detail::io_segment_buffer<R>>{
+            ring_, fd_, IORING_OP_WRITEV,
+            detail::make_io_segments(std::forward<R>(segments))};
+    }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_IO_URING_HPP_
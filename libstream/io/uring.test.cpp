@@ -0,0 +1,251 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/io/uring.hpp>
+
+#include <libstream/filter.hpp>
+#include <libstream/span.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/mocks/callback.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+using namespace stream;
+using namespace std;
+
+namespace
+{
+struct pipe_fds
+{
+    int fds_[2];
+
+    pipe_fds() { REQUIRE(::pipe(fds_) == 0); }
+    ~pipe_fds()
+    {
+        ::close(fds_[0]);
+        ::close(fds_[1]);
+    }
+};
+
+void run_until(io_uring_context& ring, bool& flag)
+{
+    while(!flag) { ring.run_once(true); }
+}
+} // namespace
+
+SCENARIO("io_uring streams on a pipe.")
+{
+    io_uring_context ring;
+    if(ring.error() != 0)
+    {
+        WARN("io_uring is not available: " << ring.error());
+        return;
+    }
+
+    GIVEN("Streams on both ends of a pipe.")
+    {
+        pipe_fds              p;
+        io_uring_stream<char> in{ring, p.fds_[0]};
+        io_uring_stream<char> out{ring, p.fds_[1]};
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        done_callback_mock   read_done, write_done;
+        read_callback_mock   value_mock;
+
+        WHEN("A range is read while it is written in two parts.")
+        {
+            array<char, 5> buffer{};
+            auto           reader = in.read(buffer);
+            reader.submit(base_token{error_mock, cancel_mock, read_done});
+            REQUIRE(ring.run_once() == 0);
+
+            array<char, 3> first{'a', 'b', 'c'};
+            array<char, 2> second{'d', 'e'};
+            auto           writer1 = out.write(first);
+            auto           writer2 = out.write(second);
+
+            bool finished = false;
+            REQUIRE_CALL(write_done, call()).TIMES(2);
+            REQUIRE_CALL(read_done, call()).LR_SIDE_EFFECT(finished = true);
+            writer1.submit(base_token{error_mock, cancel_mock, write_done});
+            writer2.submit(base_token{error_mock, cancel_mock, write_done});
+            run_until(ring, finished);
+
+            THEN("The short read is completed with the second part.")
+            {
+                REQUIRE(buffer == array{'a', 'b', 'c', 'd', 'e'});
+            }
+        }
+
+        WHEN("A pending read is cancelled.")
+        {
+            bool finished = false;
+            auto reader   = in.read();
+            reader.submit(
+                read_token<char>{error_mock, cancel_mock, value_mock});
+            ring.run_once();
+
+            REQUIRE_CALL(cancel_mock, call()).LR_SIDE_EFFECT(finished = true);
+            reader.cancel();
+            run_until(ring, finished);
+        }
+
+        WHEN("The write end is closed.")
+        {
+            ::close(p.fds_[1]);
+            p.fds_[1] = ::open("/dev/null", O_WRONLY);
+
+            THEN("A read fails with ENODATA.")
+            {
+                bool finished = false;
+                auto reader   = in.read();
+                REQUIRE_CALL(error_mock, call(ENODATA))
+                    .LR_SIDE_EFFECT(finished = true);
+                reader.submit(
+                    read_token<char>{error_mock, cancel_mock, value_mock});
+                run_until(ring, finished);
+            }
+        }
+
+        WHEN("Values are written synchronously through an adaptor.")
+        {
+            auto s = out | transform_write([](char c) { return c + 1; });
+            s.write('a').submit();
+            s.write('b').submit();
+
+            THEN("They are read back synchronously.")
+            {
+                REQUIRE(in.read().submit() == 'b');
+                REQUIRE(in.read().submit() == 'c');
+            }
+        }
+
+        WHEN("A filtered range is written.")
+        {
+            string data   = "hello world";
+            auto   s      = filter_write(out, [](char c) { return c != 'l'; });
+            auto   writer = s.write(data);
+
+            THEN("The runs are written with one vectored write.")
+            {
+                bool written = false;
+                REQUIRE_CALL(write_done, call()).LR_SIDE_EFFECT(written = true);
+                writer.submit(base_token{error_mock, cancel_mock, write_done});
+                run_until(ring, written);
+
+                array<char, 8> buffer{};
+                in.read(buffer).submit();
+                REQUIRE(string(buffer.begin(), buffer.end()) == "heo word");
+            }
+        }
+
+        WHEN("Empty ranges are written.")
+        {
+            array<char, 0>             empty{};
+            array<span<const char>, 1> segments{span<const char>{}};
+
+            THEN("They complete without being submitted to the ring.")
+            {
+                REQUIRE_CALL(write_done, call()).TIMES(3);
+                out.write(empty).submit(
+                    base_token{error_mock, cancel_mock, write_done});
+                out.writev(segments).submit(
+                    base_token{error_mock, cancel_mock, write_done});
+                filter_write(out, [](char) { return false; })
+                    .write(string{"abc"})
+                    .submit(base_token{error_mock, cancel_mock, write_done});
+                REQUIRE(ring.run_once() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("io_uring streams on a regular file.")
+{
+    io_uring_context ring;
+    if(ring.error() != 0)
+    {
+        WARN("io_uring is not available: " << ring.error());
+        return;
+    }
+
+    GIVEN("A stream on a temporary file.")
+    {
+        char name[] = "/tmp/stream_uring_XXXXXX";
+        int  fd     = ::mkstemp(name);
+        REQUIRE(fd >= 0);
+        ::unlink(name);
+        io_uring_stream<int> file{ring, fd};
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        done_callback_mock   done_mock;
+
+        WHEN("A range is written and read back.")
+        {
+            array<int, 4> out{1, 2, 3, 4};
+            array<int, 4> in{};
+            bool          finished = false;
+
+            REQUIRE_CALL(done_mock, call())
+                .TIMES(2)
+                .LR_SIDE_EFFECT(finished = true);
+
+            auto writer = file.write(out);
+            writer.submit(base_token{error_mock, cancel_mock, done_mock});
+            run_until(ring, finished);
+
+            ::lseek(fd, 0, SEEK_SET);
+            finished    = false;
+            auto reader = file.read(in);
+            reader.submit(base_token{error_mock, cancel_mock, done_mock});
+            run_until(ring, finished);
+
+            THEN("The contents match.") { REQUIRE(in == out); }
+        }
+
+        ::close(fd);
+    }
+}
+
+SCENARIO("io_uring streams on a ring which could not be set up.")
+{
+    io_uring_context ring{0};
+    REQUIRE(ring.error() != 0);
+
+    GIVEN("A stream on a pipe.")
+    {
+        pipe_fds              p;
+        io_uring_stream<char> out{ring, p.fds_[1]};
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        done_callback_mock   done_mock;
+
+        WHEN("A value is written.")
+        {
+            auto writer = out.write('a');
+
+            THEN("The error of the setup is reported to the token.")
+            {
+                REQUIRE_CALL(error_mock, call(ring.error()));
+                writer.submit(base_token{error_mock, cancel_mock, done_mock});
+                writer.cancel();
+                REQUIRE(ring.run_once() == 0);
+            }
+        }
+    }
+}
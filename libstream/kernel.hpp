@@ -0,0 +1,312 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_KERNEL_HPP_
+#define LIBSTREAM_KERNEL_HPP_
+
+#include <libstream/span.hpp>
+
+#include <experimental/ranges/range>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Width of the blocks processed by the bulk kernels. Blocks are written with
+ * GCC vector extensions, which are lowered to AVX2 or SSE instructions
+ * depending on the target and to scalar code where neither is available.
+ */
+#ifdef __AVX2__
+inline constexpr std::size_t simd_bytes = 32;
+#else
+inline constexpr std::size_t simd_bytes = 16;
+#endif
+
+template<class T>
+using simd_t __attribute__((vector_size(simd_bytes))) = T;
+
+/*!
+ * Applies block to all whole blocks of the range and scalar to the remaining
+ * values, in place.
+ */
+template<class T, class Block, class Scalar>
+void for_each_block(span<T> r, Block&& block, Scalar&& scalar) noexcept
+{
+    constexpr std::size_t n = sizeof(simd_t<T>) / sizeof(T);
+
+    T* p    = r.data();
+    T* last = p + r.size();
+    for(; static_cast<std::size_t>(last - p) >= n; p += n)
+    {
+        simd_t<T> v;
+        std::memcpy(&v, p, sizeof(v));
+        v = block(v);
+        std::memcpy(p, &v, sizeof(v));
+    }
+    for(; p != last; ++p) { *p = scalar(*p); }
+}
+
+/*!
+ * Whether all or any lanes of a comparison result are set.
+ */
+template<class M> bool all_lanes(const M& mask) noexcept
+{
+    std::uint64_t words[sizeof(M) / sizeof(std::uint64_t)];
+    std::memcpy(words, &mask, sizeof(words));
+    std::uint64_t all = ~std::uint64_t{0};
+    for(auto w : words) { all &= w; }
+    return all == ~std::uint64_t{0};
+}
+
+template<class M> bool any_lane(const M& mask) noexcept
+{
+    std::uint64_t words[sizeof(M) / sizeof(std::uint64_t)];
+    std::memcpy(words, &mask, sizeof(words));
+    std::uint64_t any = 0;
+    for(auto w : words) { any |= w; }
+    return any != 0;
+}
+
+/*!
+ * Moves the values of the range which are accepted to its front, keeping
+ * their order, and returns their number. block returns the comparison result
+ * of a whole block. Blocks accepted as a whole are moved at once, all others
+ * are compacted without a branch per value.
+ */
+template<class T, class Block, class Scalar>
+std::size_t compact(span<T> r, Block&& block, Scalar&& scalar) noexcept
+{
+    constexpr std::size_t n = sizeof(simd_t<T>) / sizeof(T);
+
+    T* in   = r.data();
+    T* out  = r.data();
+    T* last = in + r.size();
+    for(; static_cast<std::size_t>(last - in) >= n; in += n)
+    {
+        simd_t<T> v;
+        std::memcpy(&v, in, sizeof(v));
+        auto accepted = block(v);
+        if(all_lanes(accepted))
+        {
+            std::memmove(out, in, sizeof(v));
+            out += n;
+        }
+        else if(any_lane(accepted))
+        {
+            for(std::size_t i = 0; i < n; ++i)
+            {
+                *out = v[i];
+                out += accepted[i] != 0;
+            }
+        }
+    }
+    for(; in != last; ++in)
+    {
+        *out = *in;
+        out += scalar(*out) ? 1 : 0;
+    }
+    return static_cast<std::size_t>(out - r.data());
+}
+
+/*!
+ * Lane type in which values are computed. Integers are computed unsigned, so
+ * that they wrap without undefined behaviour.
+ */
+template<class T, bool = std::is_integral_v<T>> struct wrapping
+{
+    using type = T;
+};
+
+template<class T> struct wrapping<T, true>
+{
+    using type = std::make_unsigned_t<T>;
+};
+
+template<class T> using wrapping_t = typename wrapping<T>::type;
+
+/*!
+ * Type in which single values are computed. Unlike wrapping_t, integers
+ * narrower than int are not promoted to a signed int.
+ */
+template<class T> using scalar_wrapping_t = decltype(wrapping_t<T>{} + 0u);
+
+template<class T, std::size_t... I>
+constexpr simd_t<std::uint8_t> byte_swap_mask(std::index_sequence<I...>)
+{
+    return simd_t<std::uint8_t>{static_cast<std::uint8_t>(
+        I / sizeof(T) * sizeof(T) + sizeof(T) - 1 - I % sizeof(T))...};
+}
+
+template<class R>
+using contiguous_value_t = std::remove_reference_t<decltype(
+    *std::experimental::ranges::data(std::declval<R&>()))>;
+} // namespace detail
+
+/*!
+ * A function object which, besides single values, transforms a span of
+ * values in place. transform_read() applies such a kernel to contiguous
+ * ranges in bulk after they were read, instead of value by value.
+ */
+template<class F, class T>
+concept bool BulkKernel =
+    std::is_same_v<typename std::remove_reference_t<F>::value_type, T> &&
+    requires(const std::remove_reference_t<F>& f, span<T> r)
+{
+    f(r);
+};
+
+/*!
+ * Multiplies values by a factor. Integers wrap like the scalar operation.
+ */
+template<class T> class scale_kernel
+{
+    static_assert(std::is_arithmetic_v<T>, "Only arithmetic types are scaled.");
+
+    using wrapping_t      = detail::wrapping_t<T>;
+    using simd_t          = detail::simd_t<T>;
+    using wrapping_simd_t = detail::simd_t<wrapping_t>;
+
+  public:
+    using value_type = T;
+
+    T factor;
+
+    constexpr T operator()(T v) const noexcept
+    {
+        using scalar_t = detail::scalar_wrapping_t<T>;
+        return static_cast<T>(scalar_t(v) * scalar_t(factor));
+    }
+
+    void operator()(span<T> r) const noexcept
+    {
+        detail::for_each_block(r,
+                               [f = wrapping_t(factor)](simd_t v) {
+                                   return reinterpret_cast<simd_t>(
+                                       reinterpret_cast<wrapping_simd_t>(v) *
+                                       f);
+                               },
+                               *this);
+    }
+};
+
+/*!
+ * Adds an offset to values. Integers wrap like the scalar operation.
+ */
+template<class T> class offset_kernel
+{
+    static_assert(std::is_arithmetic_v<T>, "Only arithmetic types are offset.");
+
+    using wrapping_t      = detail::wrapping_t<T>;
+    using simd_t          = detail::simd_t<T>;
+    using wrapping_simd_t = detail::simd_t<wrapping_t>;
+
+  public:
+    using value_type = T;
+
+    T offset;
+
+    constexpr T operator()(T v) const noexcept
+    {
+        using scalar_t = detail::scalar_wrapping_t<T>;
+        return static_cast<T>(scalar_t(v) + scalar_t(offset));
+    }
+
+    void operator()(span<T> r) const noexcept
+    {
+        detail::for_each_block(r,
+                               [o = wrapping_t(offset)](simd_t v) {
+                                   return reinterpret_cast<simd_t>(
+                                       reinterpret_cast<wrapping_simd_t>(v) +
+                                       o);
+                               },
+                               *this);
+    }
+};
+
+/*!
+ * Clamps values to [low, high], e.g. to saturate samples before they are
+ * narrowed.
+ */
+template<class T> struct saturate_kernel
+{
+    static_assert(std::is_arithmetic_v<T>,
+                  "Only arithmetic types are saturated.");
+
+    using value_type = T;
+
+    T low;
+    T high;
+
+    constexpr T operator()(T v) const noexcept
+    {
+        return v < low ? low : (v > high ? high : v);
+    }
+
+    void operator()(span<T> r) const noexcept
+    {
+        detail::for_each_block(r,
+                               [l = low, h = high](auto v) {
+                                   decltype(v) lv = l - decltype(v){};
+                                   decltype(v) hv = h - decltype(v){};
+                                   v = v < lv ? lv : v;
+                                   return v > hv ? hv : v;
+                               },
+                               *this);
+    }
+};
+
+/*!
+ * Reverses the byte order of integers, e.g. of big endian samples.
+ */
+template<class T> struct byte_swap_kernel
+{
+    static_assert(std::is_integral_v<T> &&
+                      (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                  "Only 16, 32 and 64 bit integers are byte swapped.");
+
+    using value_type = T;
+
+    constexpr T operator()(T v) const noexcept
+    {
+        if constexpr(sizeof(T) == 2)
+        { return static_cast<T>(__builtin_bswap16(v)); }
+        else if constexpr(sizeof(T) == 4)
+        {
+            return static_cast<T>(__builtin_bswap32(v));
+        }
+        else
+        {
+            return static_cast<T>(__builtin_bswap64(v));
+        }
+    }
+
+    void operator()(span<T> r) const noexcept
+    {
+        using bytes_t = detail::simd_t<std::uint8_t>;
+        constexpr bytes_t mask = detail::byte_swap_mask<T>(
+            std::make_index_sequence<detail::simd_bytes>{});
+
+        detail::for_each_block(
+            r,
+            [mask](auto v) {
+                return reinterpret_cast<decltype(v)>(
+                    __builtin_shuffle(reinterpret_cast<bytes_t>(v), mask));
+            },
+            *this);
+    }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_KERNEL_HPP_
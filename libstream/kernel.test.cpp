@@ -0,0 +1,120 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/kernel.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+template<class K, class T> void require_bulk_equals_scalar(K k, T seed)
+{
+    for(size_t n = 0; n < 70; ++n)
+    {
+        vector<T> bulk(n), scalar(n);
+        for(size_t i = 0; i < n; ++i)
+        {
+            bulk[i]   = static_cast<T>(seed * static_cast<T>(i + 1) - 1000);
+            scalar[i] = k(bulk[i]);
+        }
+        k(span<T>{bulk.data(), bulk.size()});
+        REQUIRE(bulk == scalar);
+    }
+}
+
+SCENARIO("Bulk kernels.")
+{
+    THEN("Whole blocks and the remainder are transformed like single values.")
+    {
+        require_bulk_equals_scalar(scale_kernel<int16_t>{3}, int16_t{517});
+        require_bulk_equals_scalar(scale_kernel<float>{0.5f}, 1.25f);
+        require_bulk_equals_scalar(offset_kernel<int32_t>{-7}, 123457);
+        require_bulk_equals_scalar(offset_kernel<double>{1.5}, 0.75);
+        require_bulk_equals_scalar(saturate_kernel<int16_t>{-500, 700},
+                                   int16_t{77});
+        require_bulk_equals_scalar(saturate_kernel<float>{-5.f, 7.f}, 1.3f);
+        require_bulk_equals_scalar(byte_swap_kernel<uint16_t>{},
+                                   uint16_t{0x1234});
+        require_bulk_equals_scalar(byte_swap_kernel<int32_t>{}, 0x12345678);
+        require_bulk_equals_scalar(byte_swap_kernel<uint64_t>{},
+                                   uint64_t{0x0102030405060708});
+    }
+
+    THEN("Integers wrap without overflowing.")
+    {
+        REQUIRE(scale_kernel<int32_t>{2}(INT32_MAX) == -2);
+        REQUIRE(scale_kernel<uint16_t>{0xffff}(0xffff) == 1);
+        REQUIRE(offset_kernel<int32_t>{1}(INT32_MAX) == INT32_MIN);
+        REQUIRE(offset_kernel<int8_t>{-1}(INT8_MIN) == INT8_MAX);
+        require_bulk_equals_scalar(scale_kernel<int32_t>{65537}, 40009);
+        require_bulk_equals_scalar(offset_kernel<int32_t>{INT32_MAX}, 3);
+    }
+
+    THEN("Only kernels of the range's value type are used in bulk.")
+    {
+        auto f = [](auto v) { return v; };
+        REQUIRE(BulkKernel<scale_kernel<int>, int>);
+        REQUIRE(BulkKernel<scale_kernel<int>&, int>);
+        REQUIRE(!BulkKernel<scale_kernel<int>, short>);
+        REQUIRE(!BulkKernel<decltype(f), int>);
+    }
+}
+
+SCENARIO("Range reads with a bulk kernel.")
+{
+    read_mock reader;
+    auto      s = stream::transform_read(reader, scale_kernel<int>{3});
+
+    REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 2, 3});
+    array<int, 3> a{};
+    auto          sender = s.read(a);
+
+    WHEN("It is submitted synchronously.")
+    {
+        REQUIRE_CALL(reader.range_sender_, submit());
+        sender.submit();
+
+        THEN("The range is transformed.") { REQUIRE(a == array{3, 6, 9}); }
+    }
+
+    WHEN("It is submitted asynchronously.")
+    {
+        base_token t;
+        REQUIRE_CALL(reader.range_sender_, submit(ANY(base_token)))
+            .LR_SIDE_EFFECT(t = _1);
+        done_callback_mock   done_mock;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        sender.submit(base_token{error_mock, cancel_mock, done_mock});
+
+        THEN("The range is transformed on completion.")
+        {
+            REQUIRE(a == array{1, 2, 3});
+            REQUIRE_CALL(done_mock, call());
+            t.done();
+            REQUIRE(a == array{3, 6, 9});
+        }
+
+        THEN("Errors are forwarded.")
+        {
+            REQUIRE_CALL(error_mock, call(dummy_error));
+            t.error(dummy_error);
+        }
+    }
+}
@@ -0,0 +1,237 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_MEASURE_HPP_
+#define LIBSTREAM_MEASURE_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/detail/wrap.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace stream
+{
+/*!
+ * Log-linear histogram of latencies with fixed memory.
+ *
+ * Latencies below 2^Precision ns are counted exactly, every larger power of
+ * two is split into 2^(Precision - 1) buckets, so percentiles are reported
+ * with a relative error below 2^(1 - Precision). Recording only increments
+ * two counters. Concurrent recording from several threads is safe but may
+ * lose counts, use a histogram per thread where that matters.
+ */
+template<unsigned Precision = 5> class basic_histogram
+{
+    static_assert(Precision >= 1 && Precision < 32,
+                  "Precision has to be between 1 and 31 bits.");
+
+    static constexpr std::uint64_t linear  = std::uint64_t{1} << Precision;
+    static constexpr std::uint64_t half    = linear / 2;
+    static constexpr std::size_t   buckets = linear + (64 - Precision) * half;
+
+    std::array<std::atomic<std::uint64_t>, buckets> counts_{};
+    std::atomic<std::uint64_t>                      count_{0};
+    std::atomic<std::uint64_t>                      max_{0};
+
+    static void increment(std::atomic<std::uint64_t>& c) noexcept
+    {
+        c.store(c.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    }
+
+    static std::size_t index(std::uint64_t v) noexcept
+    {
+        if(v < linear) { return v; }
+        unsigned shift = 63 - __builtin_clzll(v) - (Precision - 1);
+        return linear + (shift - 1) * half + ((v >> shift) - half);
+    }
+
+    static std::uint64_t highest_equivalent(std::size_t i) noexcept
+    {
+        if(i < linear) { return i; }
+        auto     k        = i - linear;
+        unsigned shift    = k / half + 1;
+        auto     mantissa = half + k % half;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+  public:
+    void record(std::chrono::nanoseconds latency) noexcept
+    {
+        auto v = static_cast<std::uint64_t>(
+            latency.count() < 0 ? 0 : latency.count());
+        increment(counts_[index(v)]);
+        increment(count_);
+        if(v > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(v, std::memory_order_relaxed);
+        }
+    }
+
+    std::uint64_t count() const noexcept
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds max() const noexcept
+    {
+        return std::chrono::nanoseconds(max_.load(std::memory_order_relaxed));
+    }
+
+    /*!
+     * Latency below which p percent of the recorded latencies lie, e.g.
+     * percentile(99.9) for p999.
+     */
+    std::chrono::nanoseconds percentile(double p) const noexcept
+    {
+        auto total = count();
+        if(total == 0) { return std::chrono::nanoseconds(0); }
+
+        auto target = static_cast<std::uint64_t>(std::ceil(p / 100 * total));
+        if(target == 0) { target = 1; }
+
+        std::uint64_t seen = 0;
+        for(std::size_t i = 0; i < buckets; ++i)
+        {
+            seen += counts_[i].load(std::memory_order_relaxed);
+            if(seen >= target)
+            {
+                auto max = max_.load(std::memory_order_relaxed);
+                return std::chrono::nanoseconds(
+                    std::min<std::uint64_t>(highest_equivalent(i), max));
+            }
+        }
+        return max();
+    }
+
+    void reset() noexcept
+    {
+        for(auto& c : counts_) { c.store(0, std::memory_order_relaxed); }
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+};
+
+using histogram = basic_histogram<>;
+
+namespace detail
+{
+template<class H> class stopwatch
+{
+    using clock = std::chrono::steady_clock;
+
+    H&                histogram_;
+    clock::time_point start_ = clock::now();
+
+  public:
+    explicit stopwatch(H& h) : histogram_(h) {}
+    ~stopwatch() { histogram_.record(clock::now() - start_); }
+
+    stopwatch(const stopwatch&) = delete;
+    stopwatch& operator=(const stopwatch&) = delete;
+};
+
+template<class Token, class C, class H> class measure_context;
+
+/*!
+ * Records the time from the submission of the child to its completion.
+ * Cancelled operations are not recorded.
+ */
+template<class... Ret, class C, class H>
+class measure_context<token<Ret...>, C, H>
+{
+    using this_t = measure_context<token<Ret...>, C, H>;
+    using clock  = std::chrono::steady_clock;
+
+    C                 child_;
+    H&                histogram_;
+    token<Ret...>     token_;
+    clock::time_point start_;
+    LIBSTREAM_TRACE_TOKEN(token<Ret...>)
+
+    void record() { histogram_.record(clock::now() - start_); }
+
+    void error_handler(error_code e)
+    {
+        record();
+        token_.error(e);
+    }
+
+    void cancel_handler() { token_.cancelled(); }
+
+    void done_handler(Ret... v)
+    {
+        record();
+        token_.done(std::move(v)...);
+    }
+
+  public:
+    measure_context(C&& c, H& h) : child_(std::forward<C>(c)), histogram_(h)
+    {
+    }
+
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("measure")
+        stopwatch<H> s{histogram_};
+        return child_.submit();
+    }
+
+    void submit(token<Ret...>&& t)
+    {
+        token_ = LIBSTREAM_TRACE_WRAP("measure", std::move(t));
+        start_ = clock::now();
+        child_.submit(token<Ret...>{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            SA::delegate<void(Ret...)>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    void cancel() { child_.cancel(); }
+};
+} // namespace detail
+
+/*!
+ * Records the latency of all operations of a stream into a histogram.
+ */
+template<Streamable S, class H>
+using measure_fn = detail::wrap_fn<detail::measure_context, S, H>;
+
+template<class H> class measure_pipe
+{
+    H& histogram_;
+
+  public:
+    constexpr measure_pipe(H& h) : histogram_(h) {}
+
+    template<Streamable S> Streamable pipe(S&& s) const
+    {
+        return measure_fn<S, H>{std::forward<S>(s), histogram_};
+    }
+};
+
+template<class H> Pipeable measure(H& h) { return measure_pipe<H>{h}; }
+
+template<Streamable S, class H> Streamable measure(S&& stream, H& h)
+{
+    return measure_fn<S, H>{std::forward<S>(stream), h};
+}
+
+} // namespace stream
+
+#endif // LIBSTREAM_MEASURE_HPP_
@@ -0,0 +1,164 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/measure.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <chrono>
+
+using namespace stream;
+using namespace std;
+using namespace std::chrono_literals;
+using trompeloeil::_;
+
+SCENARIO("Latency histograms.")
+{
+    GIVEN("An empty histogram.")
+    {
+        histogram h;
+
+        THEN("All percentiles are zero.")
+        {
+            REQUIRE(h.count() == 0);
+            REQUIRE(h.percentile(50) == 0ns);
+        }
+
+        WHEN("The latencies 1 to 100 ns are recorded.")
+        {
+            for(int i = 1; i <= 100; ++i) { h.record(chrono::nanoseconds(i)); }
+
+            THEN("Percentiles are exact for small latencies.")
+            {
+                REQUIRE(h.count() == 100);
+                REQUIRE(h.percentile(10) == 10ns);
+                REQUIRE(h.percentile(100) == 100ns);
+            }
+
+            THEN("Larger percentiles are within the relative error.")
+            {
+                REQUIRE(h.percentile(50) >= 50ns);
+                REQUIRE(h.percentile(50) <= 50ns + 50ns / 16);
+                REQUIRE(h.percentile(99) >= 99ns);
+                REQUIRE(h.percentile(99) <= 99ns + 99ns / 16);
+            }
+
+            AND_WHEN("It is reset.")
+            {
+                h.reset();
+                REQUIRE(h.count() == 0);
+                REQUIRE(h.max() == 0ns);
+            }
+        }
+
+        WHEN("Latencies of different magnitudes are recorded.")
+        {
+            h.record(1us);
+            h.record(1ms);
+            h.record(1s);
+            h.record(1h);
+
+            THEN("Each is found at its percentile.")
+            {
+                chrono::nanoseconds us = 1us, ms = 1ms, s = 1s;
+                REQUIRE(h.percentile(25) >= us);
+                REQUIRE(h.percentile(25) <= us + us / 16);
+                REQUIRE(h.percentile(50) >= ms);
+                REQUIRE(h.percentile(50) <= ms + ms / 16);
+                REQUIRE(h.percentile(75) >= s);
+                REQUIRE(h.percentile(75) <= s + s / 16);
+                REQUIRE(h.percentile(99.9) == 1h);
+            }
+        }
+    }
+}
+
+SCENARIO("Measuring stream latencies.")
+{
+    histogram h;
+
+    GIVEN("A measured write stream.")
+    {
+        write_mock writer;
+        auto       s = writer | measure(h);
+
+        REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_);
+        auto sender = s.write(1);
+
+        test_sync_submit(writer.sender_, sender);
+        test_async_write_submit(writer.sender_, sender);
+        test_async_write_submit(writer.sender_, sender, dummy_error);
+
+        WHEN("A write is completed.")
+        {
+            base_token t;
+            REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t = _1);
+            done_callback_mock   done_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+            sender.submit(base_token{error_mock, cancel_mock, done_mock});
+
+            THEN("Its latency is recorded.")
+            {
+                REQUIRE(h.count() == 0);
+                REQUIRE_CALL(done_mock, call());
+                t.done();
+                REQUIRE(h.count() == 1);
+            }
+
+            THEN("A cancelled write is not recorded.")
+            {
+                REQUIRE_CALL(cancel_mock, call());
+                t.cancelled();
+                REQUIRE(h.count() == 0);
+            }
+        }
+
+        WHEN("A write is submitted synchronously.")
+        {
+            REQUIRE_CALL(writer.sender_, submit());
+            sender.submit();
+
+            THEN("Its latency is recorded.") { REQUIRE(h.count() == 1); }
+        }
+    }
+
+    GIVEN("A measured read stream.")
+    {
+        read_mock reader;
+        auto      s = measure(reader, h);
+
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        auto sender = s.read();
+
+        test_sync_read_submit(reader.sender_, sender, test_pair{1, 1});
+        test_async_read_submit(reader.sender_, sender, test_pair{1, 1});
+        test_async_read_submit(reader.sender_, sender, test_pair{1, 1},
+                               dummy_error);
+    }
+
+    GIVEN("A measured range read.")
+    {
+        read_mock reader;
+        auto      s = measure(reader, h);
+
+        REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 2});
+        array<int, 2> a{};
+        auto          sender = s.read(a);
+
+        test_sync_submit(reader.range_sender_, sender);
+        test_async_range_submit(reader.range_sender_, sender);
+    }
+}
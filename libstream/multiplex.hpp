@@ -0,0 +1,279 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_MULTIPLEX_HPP_
+#define LIBSTREAM_MULTIPLEX_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/tuple.hpp>
+#include <libstream/trace.hpp>
+
+#include <bitset>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+/*!
+ * Reads from all sources at once. The first source to complete wins, the
+ * reads still in flight are cancelled and their results are dropped.
+ */
+struct first_ready_t
+{
+};
+inline constexpr first_ready_t first_ready{};
+
+/*!
+ * Reads from one source per operation, cycling through the sources.
+ */
+struct round_robin_t
+{
+};
+inline constexpr round_robin_t round_robin{};
+
+template<class P>
+concept bool MultiplexPolicy =
+    std::is_same_v<P, first_ready_t> || std::is_same_v<P, round_robin_t>;
+
+namespace detail
+{
+template<class C, class... Cs> struct multiplex_value
+{
+    using type = decltype(std::declval<C>().submit());
+    static_assert((std::is_same_v<type, decltype(std::declval<Cs>().submit())> &&
+                   ...),
+                  "All sources have to read the same type.");
+};
+
+template<class... C> class round_robin_context
+{
+    static constexpr std::size_t size = sizeof...(C);
+    using value_type = typename multiplex_value<C...>::type;
+
+    std::tuple<C...> children_;
+    std::size_t&     next_;
+    std::size_t      current_;
+    LIBSTREAM_TRACE_TOKEN(read_token<value_type>)
+
+    void select()
+    {
+        current_ = next_;
+        next_    = (next_ + 1) % size;
+    }
+
+  public:
+    round_robin_context(std::size_t& next, C&&... c)
+        : children_(std::forward<C>(c)...), next_(next)
+    {
+    }
+
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("multiplex_read")
+        select();
+        return invoke_at<value_type>(
+            children_, current_, [](auto& child) { return child.submit(); },
+            std::index_sequence_for<C...>{});
+    }
+
+    void submit(read_token<value_type>&& t)
+    {
+        select();
+        auto traced = LIBSTREAM_TRACE_WRAP("multiplex_read", std::move(t));
+        visit_at(children_, current_,
+                 [&traced](auto& child) { child.submit(std::move(traced)); },
+                 std::index_sequence_for<C...>{});
+    }
+
+    void cancel()
+    {
+        visit_at(children_, current_, [](auto& child) { child.cancel(); },
+                 std::index_sequence_for<C...>{});
+    }
+};
+
+template<class... C>
+round_robin_context(std::size_t&, C&&...)->round_robin_context<C...>;
+
+template<class... C> class first_ready_context
+{
+    static constexpr std::size_t size = sizeof...(C);
+    using value_type = typename multiplex_value<C...>::type;
+
+    std::tuple<C...>          children_;
+    std::size_t&              next_;
+    read_token<value_type>    token_;
+    std::bitset<size>         running_;
+    std::size_t               remaining_;
+    std::optional<value_type> value_;
+    error_code                error_;
+    bool                      decided_;
+    bool                      failed_;
+    LIBSTREAM_TRACE_TOKEN(read_token<value_type>)
+
+    template<std::size_t I> void submit_child()
+    {
+        if(decided_)
+        {
+            finish_child();
+            return;
+        }
+
+        using this_t = first_ready_context<C...>;
+        running_.set(I);
+        std::get<I>(children_).submit(read_token<value_type>{
+            error_token::template create<this_t,
+                                         &this_t::template error_handler<I>>(
+                this),
+            cancel_token::template create<this_t,
+                                          &this_t::template cancel_handler<I>>(
+                this),
+            read_done_token<value_type>::template create<
+                this_t, &this_t::template done_handler<I>>(this)});
+    }
+
+    template<std::size_t... I> void submit_all(std::index_sequence<I...>)
+    {
+        (submit_child<I>(), ...);
+    }
+
+    template<std::size_t... I> void cancel_running(std::index_sequence<I...>)
+    {
+        ((running_.test(I) ? std::get<I>(children_).cancel() : void()), ...);
+    }
+
+    void decide()
+    {
+        decided_ = true;
+        cancel_running(std::index_sequence_for<C...>{});
+    }
+
+    void finish_child()
+    {
+        if(--remaining_ != 0) { return; }
+
+        if(value_) { token_.done(*value_); }
+        else if(failed_)
+        {
+            token_.error(error_);
+        }
+        else
+        {
+            token_.cancelled();
+        }
+    }
+
+    template<std::size_t I> void done_handler(value_type v)
+    {
+        running_.reset(I);
+        if(!decided_)
+        {
+            value_ = v;
+            decide();
+        }
+        finish_child();
+    }
+
+    template<std::size_t I> void error_handler(error_code e)
+    {
+        running_.reset(I);
+        if(!decided_)
+        {
+            failed_ = true;
+            error_  = e;
+            decide();
+        }
+        finish_child();
+    }
+
+    template<std::size_t I> void cancel_handler()
+    {
+        running_.reset(I);
+        finish_child();
+    }
+
+  public:
+    first_ready_context(std::size_t& next, C&&... c)
+        : children_(std::forward<C>(c)...), next_(next)
+    {
+    }
+
+    /*!
+     * Synchronous reads cannot race, they fall back to round robin.
+     */
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("multiplex_read")
+        std::size_t current = next_;
+        next_               = (next_ + 1) % size;
+        return invoke_at<value_type>(
+            children_, current, [](auto& child) { return child.submit(); },
+            std::index_sequence_for<C...>{});
+    }
+
+    void submit(read_token<value_type>&& t)
+    {
+        token_     = LIBSTREAM_TRACE_WRAP("multiplex_read", std::move(t));
+        remaining_ = size;
+        decided_   = false;
+        failed_    = false;
+        value_.reset();
+        running_.reset();
+        submit_all(std::index_sequence_for<C...>{});
+    }
+
+    void cancel()
+    {
+        decided_ = true;
+        cancel_running(std::index_sequence_for<C...>{});
+    }
+};
+
+template<class... C>
+first_ready_context(std::size_t&, C&&...)->first_ready_context<C...>;
+} // namespace detail
+
+template<MultiplexPolicy Policy, PureReadStreamable... S> class multiplex_read_fn
+{
+    std::tuple<S...>    streams_;
+    mutable std::size_t next_ = 0;
+
+    template<class... C> static auto make_context(std::size_t& next, C&&... c)
+    {
+        if constexpr(std::is_same_v<Policy, first_ready_t>)
+        { return detail::first_ready_context{next, std::forward<C>(c)...}; }
+        else
+        {
+            return detail::round_robin_context{next, std::forward<C>(c)...};
+        }
+    }
+
+  public:
+    multiplex_read_fn(Policy, S&&... s) : streams_(std::forward<S>(s)...) {}
+
+    auto read() const
+    {
+        return std::apply(
+            [this](auto&... s) { return make_context(next_, s.read()...); },
+            streams_);
+    }
+};
+
+template<MultiplexPolicy Policy, PureReadStreamable... S>
+multiplex_read_fn(Policy, S&&...)->multiplex_read_fn<Policy, S...>;
+
+template<MultiplexPolicy Policy, PureReadStreamable... S>
+PureReadStreamable multiplex_read(Policy p, S&&... s)
+{
+    return multiplex_read_fn{p, std::forward<S>(s)...};
+}
+} // namespace stream
+
+#endif /* LIBSTREAM_MULTIPLEX_HPP_ */
@@ -0,0 +1,184 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/multiplex.hpp>
+
+#include <tests/helpers/constrained_types.hpp>
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+using namespace stream;
+using namespace std;
+
+SCENARIO("First ready reads.")
+{
+    GIVEN("Three read streams.")
+    {
+        read_mock r[3];
+        auto      s = multiplex_read(first_ready, r[0], r[1], r[2]);
+
+        REQUIRE_CALL(r[0], read()).LR_RETURN(r[0].sender_);
+        REQUIRE_CALL(r[1], read()).LR_RETURN(r[1].sender_);
+        REQUIRE_CALL(r[2], read()).LR_RETURN(r[2].sender_);
+        auto sender = s.read();
+
+        WHEN("Synchronous submit is called repeatedly.")
+        {
+            REQUIRE_CALL(r[0].sender_, submit()).RETURN(1);
+            REQUIRE_CALL(r[1].sender_, submit()).RETURN(2);
+
+            THEN("The sources are read in turn.")
+            {
+                REQUIRE(sender.submit() == 1);
+                REQUIRE(sender.submit() == 2);
+            }
+        }
+
+        WHEN("Asynchronous submit is called.")
+        {
+            read_token<int> t[3];
+            REQUIRE_CALL(r[0].sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t[0] = _1);
+            REQUIRE_CALL(r[1].sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t[1] = _1);
+            REQUIRE_CALL(r[2].sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t[2] = _1);
+
+            read_callback_mock   callback_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+
+            sender.submit(
+                read_token<int>{error_mock, cancel_mock, callback_mock});
+
+            WHEN("One source completes.")
+            {
+                REQUIRE_CALL(r[0].sender_, cancel());
+                REQUIRE_CALL(r[2].sender_, cancel());
+                t[1].done(5);
+
+                THEN("Its value is reported once the others are cancelled.")
+                {
+                    t[0].cancelled();
+                    REQUIRE_CALL(callback_mock, call(5));
+                    t[2].done(6);
+                }
+            }
+
+            WHEN("One source fails.")
+            {
+                REQUIRE_CALL(r[0].sender_, cancel());
+                REQUIRE_CALL(r[1].sender_, cancel());
+                t[2].error(dummy_error);
+
+                THEN("The error is reported once the others are cancelled.")
+                {
+                    t[0].cancelled();
+                    REQUIRE_CALL(error_mock, call(dummy_error));
+                    t[1].cancelled();
+                }
+            }
+
+            WHEN("The operation is cancelled.")
+            {
+                REQUIRE_CALL(r[0].sender_, cancel());
+                REQUIRE_CALL(r[1].sender_, cancel());
+                REQUIRE_CALL(r[2].sender_, cancel());
+                sender.cancel();
+
+                t[0].cancelled();
+                t[1].done(1);
+                REQUIRE_CALL(cancel_mock, call());
+                t[2].cancelled();
+            }
+        }
+    }
+}
+
+SCENARIO("Round robin reads.")
+{
+    GIVEN("Two read streams.")
+    {
+        read_mock r[2];
+        auto      s = multiplex_read(round_robin, r[0], r[1]);
+
+        REQUIRE_CALL(r[0], read()).LR_RETURN(r[0].sender_);
+        REQUIRE_CALL(r[1], read()).LR_RETURN(r[1].sender_);
+        auto sender = s.read();
+
+        WHEN("Synchronous submit is called repeatedly.")
+        {
+            REQUIRE_CALL(r[0].sender_, submit()).RETURN(1).TIMES(2);
+            REQUIRE_CALL(r[1].sender_, submit()).RETURN(2);
+
+            THEN("The sources are read in turn.")
+            {
+                REQUIRE(sender.submit() == 1);
+                REQUIRE(sender.submit() == 2);
+                REQUIRE(sender.submit() == 1);
+            }
+        }
+
+        WHEN("Asynchronous submit is called.")
+        {
+            read_callback_mock   callback_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+
+            read_token<int> t;
+            REQUIRE_CALL(r[0].sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            sender.submit(
+                read_token<int>{error_mock, cancel_mock, callback_mock});
+
+            WHEN("The callback is invoked.")
+            {
+                REQUIRE_CALL(callback_mock, call(3));
+                t.done(3);
+
+                THEN("The next read goes to the next source.")
+                {
+                    REQUIRE_CALL(r[1].sender_, submit(ANY(read_token<int>)));
+                    sender.submit(read_token<int>{error_mock, cancel_mock,
+                                                  callback_mock});
+                }
+            }
+
+            WHEN("The operation is cancelled.")
+            {
+                REQUIRE_CALL(r[0].sender_, cancel());
+                sender.cancel();
+
+                REQUIRE_CALL(cancel_mock, call());
+                t.cancelled();
+            }
+        }
+    }
+}
+
+SCENARIO("Const multiplex adaptor.")
+{
+    GIVEN("Two readers.")
+    {
+        read_mock reader1, reader2;
+        THEN("A constant adaptor can refer to it.")
+        {
+            [[maybe_unused]] const auto s =
+                multiplex_read(first_ready, reader1, reader2);
+        }
+    }
+}
+
+SCENARIO("R-value readers.")
+{
+    [[maybe_unused]] auto s =
+        multiplex_read(round_robin, move_only_reader{}, move_only_reader{});
+}
@@ -0,0 +1,143 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_ON_HPP_
+#define LIBSTREAM_ON_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/executor.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/detail/wrap.hpp>
+#include <libstream/work_item.hpp>
+
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+template<class Token, class C, class E> class on_context;
+
+/*!
+ * Stores the completion of the child and posts itself to the executor, which
+ * then invokes the token of the caller.
+ */
+template<class... Ret, class C, class E>
+class on_context<token<Ret...>, C, E> : work_item
+{
+    using this_t = on_context<token<Ret...>, C, E>;
+
+    enum class outcome
+    {
+        done,
+        error,
+        cancelled
+    };
+
+    C                                 child_;
+    E&                                executor_;
+    token<Ret...>                     token_;
+    outcome                           outcome_ = outcome::done;
+    error_code                        error_   = 0;
+    std::optional<std::tuple<Ret...>> values_;
+    LIBSTREAM_TRACE_TOKEN(token<Ret...>)
+
+    static void execute_handler(work_item* w)
+    {
+        auto& self = *static_cast<this_t*>(w);
+        switch(self.outcome_)
+        {
+        case outcome::done:
+            std::apply(self.token_.done, std::move(*self.values_));
+            break;
+        case outcome::error: self.token_.error(self.error_); break;
+        case outcome::cancelled: self.token_.cancelled(); break;
+        }
+    }
+
+    void error_handler(error_code e)
+    {
+        outcome_ = outcome::error;
+        error_   = e;
+        executor_.post(*this);
+    }
+
+    void cancel_handler()
+    {
+        outcome_ = outcome::cancelled;
+        executor_.post(*this);
+    }
+
+    void done_handler(Ret... v)
+    {
+        outcome_ = outcome::done;
+        values_.emplace(std::move(v)...);
+        executor_.post(*this);
+    }
+
+  public:
+    on_context(C&& c, E& e)
+        : work_item(&this_t::execute_handler), child_(std::forward<C>(c)),
+          executor_(e)
+    {
+    }
+
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("on")
+        return child_.submit();
+    }
+
+    void submit(token<Ret...>&& t)
+    {
+        token_ = LIBSTREAM_TRACE_WRAP("on", std::move(t));
+        child_.submit(token<Ret...>{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            SA::delegate<void(Ret...)>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    void cancel() { child_.cancel(); }
+};
+} // namespace detail
+
+/*!
+ * Invokes the completion tokens of all operations of a stream from an
+ * executor instead of the context the lower layer completes in. Synchronous
+ * submits are not affected.
+ */
+template<Streamable S, Postable E>
+using on_fn = detail::wrap_fn<detail::on_context, S, E>;
+
+template<Postable E> class on_pipe
+{
+    E& executor_;
+
+  public:
+    constexpr on_pipe(E& executor) : executor_(executor) {}
+
+    template<Streamable S> Streamable pipe(S&& s) const
+    {
+        return on_fn<S, E>{std::forward<S>(s), executor_};
+    }
+};
+
+template<Postable E> Pipeable on(E& executor) { return on_pipe<E>{executor}; }
+
+template<Streamable S, Postable E> Streamable on(S&& stream, E& executor)
+{
+    return on_fn<S, E>{std::forward<S>(stream), executor};
+}
+
+} // namespace stream
+
+#endif // LIBSTREAM_ON_HPP_
@@ -0,0 +1,119 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/on.hpp>
+
+#include <libstream/run_loop.hpp>
+
+#include <tests/helpers/constrained_types.hpp>
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+SCENARIO("Completing on a run loop.")
+{
+    run_loop             loop;
+    error_callback_mock  error_mock;
+    cancel_callback_mock cancel_mock;
+
+    GIVEN("A read stream completing on the loop.")
+    {
+        read_mock reader;
+        auto      s = reader | on(loop);
+
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        auto sender = s.read();
+
+        test_sync_read_submit(reader.sender_, sender, test_pair{1, 1});
+
+        WHEN("Asynchronous submit is called.")
+        {
+            read_token<int> t;
+            REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+            read_callback_mock callback_mock;
+            sender.submit(
+                read_token<int>{error_mock, cancel_mock, callback_mock});
+
+            WHEN("The child completes.")
+            {
+                t.done(3);
+
+                THEN("The callback is invoked by the loop.")
+                {
+                    REQUIRE_CALL(callback_mock, call(3));
+                    REQUIRE(loop.run_once() == 1);
+                }
+            }
+
+            WHEN("The child fails.")
+            {
+                t.error(dummy_error);
+
+                THEN("The error is reported by the loop.")
+                {
+                    REQUIRE_CALL(error_mock, call(dummy_error));
+                    loop.run_once();
+                }
+            }
+
+            WHEN("The operation is cancelled.")
+            {
+                REQUIRE_CALL(reader.sender_, cancel());
+                sender.cancel();
+                t.cancelled();
+
+                THEN("The cancellation is reported by the loop.")
+                {
+                    REQUIRE_CALL(cancel_mock, call());
+                    loop.run_once();
+                }
+            }
+        }
+    }
+
+    GIVEN("A write stream completing on the loop.")
+    {
+        write_mock writer;
+        auto       s = on(writer, loop);
+
+        REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+        auto sender = s.write(2);
+
+        test_sync_submit(writer.sender_, sender);
+
+        WHEN("Asynchronous submit is called.")
+        {
+            base_token t;
+            REQUIRE_CALL(writer.sender_, submit(ANY(base_token)))
+                .LR_SIDE_EFFECT(t = _1);
+            done_callback_mock done_mock;
+            sender.submit(base_token{error_mock, cancel_mock, done_mock});
+            t.done();
+
+            THEN("The callback is invoked by the loop.")
+            {
+                REQUIRE_CALL(done_mock, call());
+                loop.run_once();
+            }
+        }
+    }
+}
+
+SCENARIO("R-value reader on a run loop.")
+{
+    run_loop              loop;
+    [[maybe_unused]] auto s = move_only_reader{} | on(loop);
+}
@@ -0,0 +1,179 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_PING_PONG_HPP_
+#define LIBSTREAM_PING_PONG_HPP_
+
+#include <libstream/callback.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/span.hpp>
+
+#include <experimental/ranges/range>
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Reads into N buffers in turn until it is cancelled.
+ *
+ * The read into the next buffer is started before a completed buffer is
+ * handed to the token, so the stream is read without gaps while the buffer
+ * is processed. A buffer is overwritten once N - 1 further buffers have been
+ * delivered. Inline completions are delivered in order with constant stack
+ * depth.
+ */
+template<class S, class Buffer, std::size_t N> class ping_pong_context
+{
+    static_assert(N >= 2, "At least two buffers are needed.");
+
+    using this_t     = ping_pong_context<S, Buffer, N>;
+    using value_type = std::remove_reference_t<decltype(
+        *std::experimental::ranges::data(std::declval<Buffer&>()))>;
+    using child_t    = base_range_context<decltype(
+        std::declval<S&>().read(std::declval<Buffer&>()))>;
+
+  public:
+    using token_type = read_token<span<const value_type>>;
+
+  private:
+    S                     stream_;
+    std::array<Buffer, N> buffers_{};
+    sender_slot<child_t>  child_;
+    token_type            token_;
+    trampoline            trampoline_;
+    std::size_t           armed_     = 0;
+    std::size_t           completed_ = 0;
+    bool                  delivery_  = false;
+    bool                  in_flight_ = false;
+    bool                  stopped_   = true;
+
+    span<const value_type> view(std::size_t i) const
+    {
+        namespace ranges = std::experimental::ranges;
+        return {ranges::data(buffers_[i]), ranges::size(buffers_[i])};
+    }
+
+    void arm(std::size_t i)
+    {
+        armed_     = i;
+        in_flight_ = true;
+        child_.emplace(child_t{stream_.read(buffers_[i])});
+        child_->submit(base_token{
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            done_token::template create<this_t, &this_t::done_handler>(
+                this)});
+    }
+
+    /*
+     * A delivery pending after a cancel is dropped, the cancelled callback
+     * has already been invoked.
+     */
+    void step()
+    {
+        if(!delivery_) { return; }
+        delivery_ = false;
+        if(stopped_) { return; }
+
+        auto i = completed_;
+        arm((i + 1) % N);
+        token_.done(view(i));
+    }
+
+    void done_handler()
+    {
+        in_flight_ = false;
+        if(stopped_)
+        {
+            token_.cancelled();
+            return;
+        }
+        completed_ = armed_;
+        delivery_  = true;
+        trampoline_.run(child_, [this] { step(); });
+    }
+
+    void error_handler(error_code e)
+    {
+        in_flight_ = false;
+        stopped_   = true;
+        token_.error(e);
+    }
+
+    void cancel_handler()
+    {
+        in_flight_ = false;
+        stopped_   = true;
+        token_.cancelled();
+    }
+
+  public:
+    explicit ping_pong_context(S&& stream) : stream_(std::forward<S>(stream))
+    {
+    }
+
+    /*!
+     * Reads the next buffer synchronously.
+     */
+    span<const value_type> submit()
+    {
+        auto i = armed_;
+        armed_ = (armed_ + 1) % N;
+        child_.emplace(child_t{stream_.read(buffers_[i])});
+        child_->submit();
+        return view(i);
+    }
+
+    /*!
+     * Starts the continuous reading. The done callback is invoked with every
+     * completed buffer, until the operation is cancelled or fails.
+     */
+    void submit(token_type&& t)
+    {
+        token_   = t;
+        stopped_ = false;
+        arm(0);
+    }
+
+    /*!
+     * Stops reading. The cancelled callback is invoked once the read in
+     * flight was cancelled, or immediately if none is in flight.
+     */
+    void cancel()
+    {
+        if(stopped_) { return; }
+        stopped_ = true;
+        if(in_flight_) { child_->cancel(); }
+        else
+        {
+            token_.cancelled();
+        }
+    }
+};
+} // namespace detail
+
+/*!
+ * Continuously reads a stream into N buffers of type Buffer, which are owned
+ * by the returned sender. See detail::ping_pong_context.
+ */
+template<class Buffer, std::size_t N = 2, PureReadStreamable S>
+auto ping_pong_read(S&& stream)
+{
+    return detail::ping_pong_context<S, Buffer, N>{std::forward<S>(stream)};
+}
+
+} // namespace stream
+
+#endif // LIBSTREAM_PING_PONG_HPP_
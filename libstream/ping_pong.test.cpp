@@ -0,0 +1,177 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/ping_pong.hpp>
+
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+/*
+ * Read stream which returns its senders by value. A sender touches its own
+ * state after its completion handler returned, like a sender which owns an
+ * operation of an event loop. The next inline_ reads complete inline.
+ */
+struct owning_reader
+{
+    struct sender
+    {
+        owning_reader*  stream_;
+        span<int>       range_;
+        unique_ptr<int> completions_ = make_unique<int>(0);
+        base_token      token_;
+
+        void fill()
+        {
+            for(auto& v : range_) { v = stream_->next_++; }
+        }
+
+        void submit() { fill(); }
+        void submit(base_token&& t)
+        {
+            if(stream_->inline_ > 0)
+            {
+                --stream_->inline_;
+                fill();
+                t.done();
+                return;
+            }
+            token_            = t;
+            stream_->pending_ = this;
+        }
+        void cancel() {}
+
+        void complete()
+        {
+            auto* completions = completions_.get();
+            stream_->pending_ = nullptr;
+            fill();
+            token_.done();
+            ++*completions;
+        }
+    };
+
+    int     next_    = 1;
+    int     inline_  = 0;
+    sender* pending_ = nullptr;
+
+    sender read(array<int, 2>& r)
+    {
+        return sender{this, {r.data(), r.size()}};
+    }
+};
+} // namespace
+
+SCENARIO("Ping-pong reads.")
+{
+    GIVEN("A read stream read into two buffers of two values.")
+    {
+        read_mock reader;
+        auto      s = ping_pong_read<array<int, 2>>(reader);
+
+        int next = 1;
+
+        WHEN("A buffer is read synchronously.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{1, 2});
+            REQUIRE_CALL(reader.range_sender_, submit());
+            auto b = s.submit();
+
+            THEN("It is returned as a span.")
+            {
+                REQUIRE(vector(b.begin(), b.end()) == vector{1, 2});
+            }
+        }
+
+        WHEN("Reading is started asynchronously.")
+        {
+            base_token t;
+            REQUIRE_CALL(reader, read_(_))
+                .TIMES(AT_LEAST(1))
+                .LR_SIDE_EFFECT(_1 = vector{next, next + 1}; next += 2);
+            REQUIRE_CALL(reader.range_sender_, submit(ANY(base_token)))
+                .TIMES(AT_LEAST(1))
+                .LR_SIDE_EFFECT(t = _1);
+
+            vector<vector<int>>  received;
+            vector<const int*>   buffers;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+            auto                 done = [&](span<const int> b) {
+                REQUIRE(next == 5 + 2 * static_cast<int>(received.size()));
+                received.emplace_back(b.begin(), b.end());
+                buffers.push_back(b.data());
+            };
+            s.submit(decltype(s)::token_type{error_mock, cancel_mock, done});
+
+            THEN("The buffers are delivered in turn and re-armed first.")
+            {
+                t.done();
+                t.done();
+                t.done();
+                REQUIRE(received ==
+                        vector<vector<int>>{{1, 2}, {3, 4}, {5, 6}});
+                REQUIRE(buffers[0] != buffers[1]);
+                REQUIRE(buffers[0] == buffers[2]);
+            }
+
+            THEN("Reading stops when it is cancelled.")
+            {
+                REQUIRE_CALL(reader.range_sender_, cancel());
+                s.cancel();
+
+                REQUIRE_CALL(cancel_mock, call());
+                t.cancelled();
+            }
+
+            THEN("Reading stops when the stream fails.")
+            {
+                REQUIRE_CALL(error_mock, call(dummy_error));
+                t.error(dummy_error);
+            }
+        }
+    }
+    GIVEN("A stream whose reads complete asynchronously and inline.")
+    {
+        owning_reader reader;
+        auto          s = ping_pong_read<array<int, 2>>(reader);
+
+        vector<vector<int>>  received;
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        auto                 done = [&](span<const int> b) {
+            received.emplace_back(b.begin(), b.end());
+        };
+        s.submit(decltype(s)::token_type{error_mock, cancel_mock, done});
+
+        WHEN("A read completes inline after an asynchronous completion.")
+        {
+            reader.inline_ = 1;
+            reader.pending_->complete();
+            reader.pending_->complete();
+
+            THEN("The buffers are delivered in turn.")
+            {
+                REQUIRE(received ==
+                        vector<vector<int>>{{1, 2}, {3, 4}, {5, 6}});
+            }
+        }
+    }
+}
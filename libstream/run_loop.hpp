@@ -0,0 +1,304 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_RUN_LOOP_HPP_
+#define LIBSTREAM_RUN_LOOP_HPP_
+
+#include <libstream/work_item.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Hashed timer wheel. Each slot holds the timers whose deadline maps to it,
+ * advancing by one tick only visits a single slot.
+ */
+template<std::size_t Slots> class timer_wheel
+{
+    std::array<work_item*, Slots> slots_{};
+    work_item*                    expired_ = nullptr;
+    std::uint64_t                 tick_    = 0;
+
+    static bool unlink(work_item** link, timer_item& t)
+    {
+        for(; *link != nullptr; link = &(*link)->next_)
+        {
+            if(*link == &t)
+            {
+                *link   = t.next_;
+                t.next_ = nullptr;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void expire_slot(std::size_t slot, work_item**& tail)
+    {
+        work_item** link = &slots_[slot];
+        while(*link != nullptr)
+        {
+            auto* timer = static_cast<timer_item*>(*link);
+            if(timer->deadline_ <= tick_)
+            {
+                *link        = timer->next_;
+                timer->next_ = nullptr;
+                *tail        = timer;
+                tail         = &timer->next_;
+            }
+            else
+            {
+                link = &timer->next_;
+            }
+        }
+    }
+
+  public:
+    /*!
+     * Inserts a timer expiring ticks after now. The wheel may lag behind now
+     * if it was not advanced recently.
+     */
+    void insert(timer_item& t, std::uint64_t now, std::uint64_t ticks)
+    {
+        t.deadline_ = std::max(tick_, now) + (ticks == 0 ? 1 : ticks);
+        auto& head  = slots_[t.deadline_ % Slots];
+        t.next_     = head;
+        head        = &t;
+    }
+
+    bool remove(timer_item& t)
+    {
+        return unlink(&slots_[t.deadline_ % Slots], t) || unlink(&expired_, t);
+    }
+
+    /*!
+     * Earliest deadline of all timers, visits every slot.
+     */
+    std::optional<std::uint64_t> next_deadline() const
+    {
+        std::optional<std::uint64_t> next;
+        for(auto* w : slots_)
+        {
+            for(; w != nullptr; w = w->next_)
+            {
+                auto deadline = static_cast<timer_item*>(w)->deadline_;
+                if(!next || deadline < *next) { next = deadline; }
+            }
+        }
+        return next;
+    }
+
+    /*!
+     * Advances to now and passes every expired timer to f. After a gap of a
+     * full revolution or more every slot is visited exactly once. Timers
+     * expiring together may be removed by the handler of an earlier one.
+     */
+    template<class F> void advance(std::uint64_t now, F&& f)
+    {
+        if(now <= tick_) { return; }
+
+        work_item** tail = &expired_;
+        if(now - tick_ >= Slots)
+        {
+            tick_ = now;
+            for(std::size_t s = 0; s < Slots; ++s) { expire_slot(s, tail); }
+        }
+        else
+        {
+            while(tick_ < now)
+            {
+                ++tick_;
+                expire_slot(tick_ % Slots, tail);
+            }
+        }
+
+        while(expired_ != nullptr)
+        {
+            auto* timer  = static_cast<timer_item*>(expired_);
+            expired_     = timer->next_;
+            timer->next_ = nullptr;
+            f(*timer);
+        }
+    }
+};
+} // namespace detail
+
+/*!
+ * Single-threaded executor.
+ *
+ * post() may be called from any thread, including interrupt context, and
+ * only links the work item into a lock-free queue. Work items and expired
+ * timers are executed by the thread calling run_once() or run(). Each call of
+ * run_once() executes one batch, items posted while the batch runs are
+ * executed by the next call, so a completion that posts again cannot starve
+ * the timers.
+ *
+ * Timers are kept in a hashed timer wheel with a resolution of one tick.
+ * schedule_after() and cancel() must be called from the thread running the
+ * loop.
+ *
+ * When idle, run() sleeps until the next deadline or until post() or stop()
+ * wake it. Only waking a sleeping loop takes a mutex, a loop fed from
+ * interrupt context has to be driven with run_once() instead.
+ */
+template<class Clock = std::chrono::steady_clock, std::size_t Slots = 256>
+class basic_run_loop
+{
+    std::atomic<work_item*>    incoming_{nullptr};
+    std::atomic<bool>          stop_{false};
+    std::atomic<bool>          sleeping_{false};
+    std::mutex                 mutex_;
+    std::condition_variable    wake_;
+    detail::timer_wheel<Slots> timers_;
+    typename Clock::duration   resolution_;
+    typename Clock::time_point start_;
+
+    std::uint64_t ticks_since_start() const
+    {
+        return static_cast<std::uint64_t>((Clock::now() - start_) /
+                                          resolution_);
+    }
+
+    void wake()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(sleeping_.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            wake_.notify_one();
+        }
+    }
+
+    /*!
+     * Blocks until a work item was posted, stop() was called or the next
+     * timer expires.
+     */
+    void sleep()
+    {
+        std::unique_lock<std::mutex> lock{mutex_};
+        sleeping_.store(true);
+        auto ready = [this] {
+            return incoming_.load() != nullptr || stop_.load();
+        };
+        if(auto deadline = timers_.next_deadline())
+        {
+            wake_.wait_for(lock,
+                           start_ + resolution_ * *deadline - Clock::now(),
+                           ready);
+        }
+        else
+        {
+            wake_.wait(lock, ready);
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+  public:
+    explicit basic_run_loop(
+        typename Clock::duration resolution = std::chrono::milliseconds{1})
+        : resolution_(resolution), start_(Clock::now())
+    {
+    }
+
+    basic_run_loop(const basic_run_loop&) = delete;
+    basic_run_loop& operator=(const basic_run_loop&) = delete;
+
+    void post(work_item& w)
+    {
+        w.next_ = incoming_.load(std::memory_order_relaxed);
+        while(!incoming_.compare_exchange_weak(w.next_, &w,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed))
+        {
+        }
+        wake();
+    }
+
+    template<class Rep, class Period>
+    void schedule_after(timer_item& t, std::chrono::duration<Rep, Period> d)
+    {
+        auto ticks = (std::chrono::duration_cast<typename Clock::duration>(d) +
+                      resolution_ - typename Clock::duration{1}) /
+                     resolution_;
+        timers_.insert(t, ticks_since_start(),
+                       static_cast<std::uint64_t>(ticks));
+    }
+
+    /*!
+     * Removes a timer which has not expired yet. Returns false if the timer
+     * was not found.
+     */
+    bool cancel(timer_item& t) { return timers_.remove(t); }
+
+    /*!
+     * Executes all expired timers and all work items posted before the call.
+     * Returns the number of executed items.
+     */
+    std::size_t run_once()
+    {
+        std::size_t count = 0;
+        timers_.advance(ticks_since_start(), [&count](timer_item& t) {
+            ++count;
+            t.execute();
+        });
+
+        work_item* reversed = incoming_.exchange(nullptr,
+                                                 std::memory_order_acquire);
+        work_item* batch = nullptr;
+        while(reversed != nullptr)
+        {
+            auto* next      = reversed->next_;
+            reversed->next_ = batch;
+            batch           = reversed;
+            reversed        = next;
+        }
+        while(batch != nullptr)
+        {
+            auto* next   = batch->next_;
+            batch->next_ = nullptr;
+            ++count;
+            batch->execute();
+            batch = next;
+        }
+        return count;
+    }
+
+    /*!
+     * Runs the loop until stop() is called.
+     */
+    void run()
+    {
+        while(!stop_.load(std::memory_order_acquire))
+        {
+            if(run_once() == 0) { sleep(); }
+        }
+        stop_.store(false, std::memory_order_relaxed);
+    }
+
+    void stop()
+    {
+        stop_.store(true, std::memory_order_release);
+        wake();
+    }
+};
+
+using run_loop = basic_run_loop<>;
+
+} // namespace stream
+
+#endif // LIBSTREAM_RUN_LOOP_HPP_
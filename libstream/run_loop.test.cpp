@@ -0,0 +1,260 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/run_loop.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+
+namespace
+{
+struct manual_clock
+{
+    using rep        = long;
+    using period     = std::milli;
+    using duration   = std::chrono::milliseconds;
+    using time_point = std::chrono::time_point<manual_clock>;
+
+    static constexpr bool is_steady = true;
+    static inline long    now_      = 0;
+
+    static time_point now() { return time_point{duration{now_}}; }
+};
+
+vector<int> executed;
+
+struct recorded_item : timer_item
+{
+    int id_;
+
+    explicit recorded_item(int id)
+        : timer_item([](work_item* w) {
+              executed.push_back(static_cast<recorded_item*>(w)->id_);
+          }),
+          id_(id)
+    {
+    }
+};
+
+struct loop_thread
+{
+    run_loop& loop_;
+    thread    thread_;
+
+    ~loop_thread()
+    {
+        if(thread_.joinable())
+        {
+            loop_.stop();
+            thread_.join();
+        }
+    }
+};
+} // namespace
+
+SCENARIO("Posting work items.")
+{
+    GIVEN("A run loop.")
+    {
+        executed.clear();
+        basic_run_loop<manual_clock, 8> loop;
+        recorded_item                   a{1}, b{2}, c{3};
+
+        WHEN("Work items are posted.")
+        {
+            loop.post(a);
+            loop.post(b);
+            loop.post(c);
+
+            THEN("Nothing is executed before the loop runs.")
+            {
+                REQUIRE(executed.empty());
+            }
+
+            THEN("The items are executed in order.")
+            {
+                REQUIRE(loop.run_once() == 3);
+                REQUIRE(executed == vector{1, 2, 3});
+                REQUIRE(loop.run_once() == 0);
+            }
+        }
+
+        WHEN("A work item posts another one.")
+        {
+            struct reposting_item : work_item
+            {
+                basic_run_loop<manual_clock, 8>* loop_;
+                work_item*                       next_item_;
+            } r;
+            r.loop_      = &loop;
+            r.next_item_ = &a;
+            r.execute_   = [](work_item* w) {
+                auto* self = static_cast<reposting_item*>(w);
+                self->loop_->post(*self->next_item_);
+            };
+            loop.post(r);
+
+            THEN("It is executed in the next batch.")
+            {
+                REQUIRE(loop.run_once() == 1);
+                REQUIRE(executed.empty());
+                REQUIRE(loop.run_once() == 1);
+                REQUIRE(executed == vector{1});
+            }
+        }
+
+        WHEN("Work items are posted from other threads.")
+        {
+            vector<recorded_item> items;
+            for(int i = 0; i < 400; ++i) { items.emplace_back(i); }
+            vector<thread> threads;
+            for(int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([&, t] {
+                    for(int i = t; i < 400; i += 4) { loop.post(items[i]); }
+                });
+            }
+            for(auto& t : threads) { t.join(); }
+
+            THEN("All of them are executed.")
+            {
+                REQUIRE(loop.run_once() == 400);
+            }
+        }
+    }
+}
+
+SCENARIO("Scheduling timers.")
+{
+    GIVEN("A run loop with a wheel of eight slots.")
+    {
+        executed.clear();
+        manual_clock::now_ = 0;
+        basic_run_loop<manual_clock, 8> loop;
+        recorded_item                   a{1}, b{2}, c{3};
+
+        auto advance = [&](long ms) {
+            for(long i = 0; i < ms; ++i)
+            {
+                ++manual_clock::now_;
+                loop.run_once();
+            }
+        };
+
+        WHEN("Timers are scheduled.")
+        {
+            loop.schedule_after(a, std::chrono::milliseconds{3});
+            loop.schedule_after(b, std::chrono::milliseconds{11});
+            loop.schedule_after(c, std::chrono::milliseconds{2});
+
+            THEN("They expire in order of their deadlines.")
+            {
+                advance(2);
+                REQUIRE(executed == vector{3});
+                advance(1);
+                REQUIRE(executed == vector{3, 1});
+                advance(7);
+                REQUIRE(executed == vector{3, 1});
+                advance(1);
+                REQUIRE(executed == vector{3, 1, 2});
+            }
+
+            WHEN("A timer is cancelled.")
+            {
+                REQUIRE(loop.cancel(a));
+
+                THEN("It is not executed.")
+                {
+                    advance(20);
+                    REQUIRE(executed == vector{3, 2});
+                    REQUIRE(!loop.cancel(a));
+                }
+            }
+        }
+
+        WHEN("A timer is scheduled after the clock moved on.")
+        {
+            manual_clock::now_ += 100;
+            loop.schedule_after(a, std::chrono::milliseconds{50});
+
+            THEN("Its deadline starts at the current time.")
+            {
+                loop.run_once();
+                REQUIRE(executed.empty());
+                advance(49);
+                REQUIRE(executed.empty());
+                advance(1);
+                REQUIRE(executed == vector{1});
+            }
+        }
+
+        WHEN("The loop was not run for longer than a revolution.")
+        {
+            loop.schedule_after(a, std::chrono::milliseconds{3});
+            loop.schedule_after(b, std::chrono::milliseconds{30});
+            manual_clock::now_ += 20;
+            loop.run_once();
+
+            THEN("Only the expired timers are executed.")
+            {
+                REQUIRE(executed == vector{1});
+                advance(10);
+                REQUIRE(executed == vector{1, 2});
+            }
+        }
+    }
+}
+
+SCENARIO("Running the loop.")
+{
+    GIVEN("A run loop running on another thread.")
+    {
+        executed.clear();
+        run_loop    loop;
+        loop_thread runner{loop, thread{[&loop] { loop.run(); }}};
+
+        WHEN("It is idle.")
+        {
+            auto cpu = clock();
+            this_thread::sleep_for(chrono::milliseconds{100});
+
+            THEN("It sleeps instead of spinning.")
+            {
+                auto used = static_cast<double>(clock() - cpu) / CLOCKS_PER_SEC;
+                REQUIRE(used < 0.05);
+            }
+        }
+
+        WHEN("A work item is posted.")
+        {
+            struct stopping_item : work_item
+            {
+                run_loop* loop_;
+            } item;
+            item.loop_    = &loop;
+            item.execute_ = [](work_item* w) {
+                executed.push_back(0);
+                static_cast<stopping_item*>(w)->loop_->stop();
+            };
+            this_thread::sleep_for(chrono::milliseconds{10});
+            loop.post(item);
+
+            THEN("The sleeping loop is woken to execute it.")
+            {
+                runner.thread_.join();
+                REQUIRE(executed == vector{0});
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_SPAN_HPP_
+#define LIBSTREAM_SPAN_HPP_
+
+#include <experimental/ranges/range>
+
+#include <cstddef>
+
+namespace stream
+{
+/*!
+ * Non-owning view of a contiguous sequence of T.
+ *
+ * Used as the segment type of vectored writes, where every segment refers to
+ * memory owned by the caller of write().
+ */
+template<class T> class span : public std::experimental::ranges::view_base
+{
+    T*          data_ = nullptr;
+    std::size_t size_ = 0;
+
+  public:
+    constexpr span() = default;
+    constexpr span(T* data, std::size_t size) : data_(data), size_(size) {}
+    constexpr span(T* first, T* last)
+        : data_(first), size_(static_cast<std::size_t>(last - first))
+    {
+    }
+
+    constexpr T*          data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool        empty() const noexcept { return size_ == 0; }
+
+    constexpr T* begin() const noexcept { return data_; }
+    constexpr T* end() const noexcept { return data_ + size_; }
+};
+
+template<class T> span(T*, std::size_t)->span<T>;
+template<class T> span(T*, T*)->span<T>;
+
+} // namespace stream
+
+#endif // LIBSTREAM_SPAN_HPP_
@@ -9,12 +9,150 @@
 #define LIBSTREAM_TAKE_UNTIL_HPP_
 
 #include <liboutput_view/take_until.hpp>
+#include <libstream/buffered.hpp>
 #include <libstream/concepts/pipe.hpp>
 #include <libstream/concepts/stream.hpp>
 #include <libstream/detail/context.hpp>
+#include <libstream/detail/take_write.hpp>
+#include <libstream/kernel.hpp>
+#include <libstream/span.hpp>
+
+#include <experimental/ranges/range>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace stream
 {
+/*!
+ * Predicate matching a terminating value, such as a newline, a NUL byte or a
+ * sentinel word. take_until_bulk_read() searches contiguous ranges for it in
+ * bulk, take_until_read() uses it like any other predicate.
+ */
+template<class T> struct terminator
+{
+    static_assert(std::is_integral_v<T>, "Only integers are searched in bulk.");
+
+    using value_type = T;
+
+    T value;
+
+    constexpr bool operator()(const T& v) const noexcept { return v == value; }
+
+    /*!
+     * Position of the first terminator in the range, or the size of the range
+     * if it contains none.
+     */
+    std::size_t find(span<const T> r) const noexcept
+    {
+        if constexpr(sizeof(T) == 1)
+        {
+            auto p = std::memchr(r.data(), static_cast<unsigned char>(value),
+                                 r.size());
+            return p == nullptr ? r.size()
+                                : static_cast<const T*>(p) - r.data();
+        }
+        else
+        {
+            using simd_t            = detail::simd_t<T>;
+            constexpr std::size_t n = sizeof(simd_t) / sizeof(T);
+
+            const simd_t needle = value - simd_t{};
+            std::size_t  i      = 0;
+            for(; i + n <= r.size(); i += n)
+            {
+                simd_t v;
+                std::memcpy(&v, r.data() + i, sizeof(v));
+                auto equal = v == needle;
+
+                std::uint64_t lanes[sizeof(equal) / sizeof(std::uint64_t)];
+                std::memcpy(lanes, &equal, sizeof(lanes));
+                std::uint64_t any = 0;
+                for(auto l : lanes) { any |= l; }
+                if(any != 0) { break; }
+            }
+            for(; i < r.size(); ++i)
+            {
+                if(r.data()[i] == value) { return i; }
+            }
+            return r.size();
+        }
+    }
+};
+
+/*!
+ * A predicate which, besides single values, finds the first match in a span.
+ */
+template<class P, class T>
+concept bool BulkTerminator =
+    std::is_same_v<typename std::remove_reference_t<P>::value_type,
+                   std::remove_cv_t<T>> &&
+    requires(const std::remove_reference_t<P>& p, span<const T> r)
+{
+    p.find(r);
+};
+
+namespace detail
+{
+/*!
+ * Copies buffered values into a contiguous range up to and including the
+ * terminator. Each contiguous part of the buffer is searched in bulk, the
+ * values following the terminator stay buffered.
+ */
+template<class T, class P> class terminated_sink
+{
+    span<T>     range_;
+    const P&    predicate_;
+    std::size_t size_  = 0;
+    bool        found_ = false;
+
+  public:
+    using token_type = base_token;
+
+    terminated_sink(span<T> r, const P& p) : range_(r), predicate_(p) {}
+
+    void rewind()
+    {
+        size_  = 0;
+        found_ = false;
+    }
+
+    template<class Buffer> bool copy_from(Buffer& b)
+    {
+        while(!found_ && size_ != range_.size())
+        {
+            auto values = b.front();
+            if(values.size() == 0) { return false; }
+
+            auto n        = std::min(values.size(), range_.size() - size_);
+            auto position = predicate_.find(span<const T>{values.data(), n});
+            found_        = position != n;
+            if(found_) { n = position + 1; }
+
+            std::copy_n(values.data(), n, range_.data() + size_);
+            b.consume(n);
+            size_ += n;
+        }
+        return true;
+    }
+
+    /*!
+     * Number of values up to and including the terminator, or the size of the
+     * range if it was not found.
+     */
+    std::size_t size() const noexcept { return size_; }
+
+    void result() const {}
+
+    void report(token_type& t) { t.done(); }
+};
+} // namespace detail
+
 template<ReadStreamable S, class P> class take_until_read_fn
 {
     S stream_;
@@ -70,6 +208,114 @@ template<class P> Pipeable take_until_read(P&& p)
 {
     return take_until_read_pipe{std::forward<P>(p)};
 }
+
+/*!
+ * Reads values up to and including a terminator, searching for it with memchr
+ * or block compares instead of a test per value.
+ *
+ * The stream is read in blocks of half the capacity like buffered_read(), and
+ * the terminator is searched for in the buffered blocks. The values following
+ * it stay buffered and are returned by the next read, so a byte stream can be
+ * split into lines or frames. The sender's size() reports the number of values
+ * read. The restrictions of buffered_read() apply.
+ */
+template<PureReadStreamable S, class P> class take_until_bulk_read_fn
+{
+    using value_type = typename P::value_type;
+    using buffer_t   = detail::read_buffer<S, value_type>;
+
+    std::unique_ptr<buffer_t> buffer_;
+    P                         predicate_;
+
+  public:
+    take_until_bulk_read_fn(S&& stream, P p, std::size_t capacity)
+        : buffer_(std::make_unique<buffer_t>(std::forward<S>(stream),
+                                             detail::half(capacity))),
+          predicate_(std::move(p))
+    {
+    }
+
+    template<std::experimental::ranges::ContiguousRange R>
+    auto read(R&& r) const
+        requires BulkTerminator<P, detail::contiguous_value_t<R>>
+    {
+        namespace ranges = std::experimental::ranges;
+        using sink_t     = detail::terminated_sink<value_type, P>;
+        return detail::buffered_read_context<buffer_t, sink_t>{
+            *buffer_,
+            sink_t{span<value_type>{ranges::data(r), ranges::size(r)},
+                   predicate_}};
+    }
+
+    /*!
+     * Number of buffered values which are not read yet.
+     */
+    std::size_t size() const noexcept { return buffer_->size(); }
+};
+
+template<PureReadStreamable S, class P>
+ReadStreamable take_until_bulk_read(S&& stream, P&& p, std::size_t capacity)
+{
+    return take_until_bulk_read_fn<S, std::decay_t<P>>{
+        std::forward<S>(stream), std::forward<P>(p), capacity};
+}
+
+template<class P> class take_until_bulk_read_pipe
+{
+    P           p_;
+    std::size_t capacity_;
+
+  public:
+    take_until_bulk_read_pipe(P p, std::size_t capacity)
+        : p_(std::move(p)), capacity_(capacity)
+    {
+    }
+
+    template<PureReadStreamable S> ReadStreamable pipe(S&& s) const
+    {
+        return take_until_bulk_read_fn<S, P>{std::forward<S>(s), P(p_),
+                                             capacity_};
+    }
+};
+
+template<class P> Pipeable take_until_bulk_read(P&& p, std::size_t capacity)
+{
+    return take_until_bulk_read_pipe<std::decay_t<P>>{std::forward<P>(p),
+                                                      capacity};
+}
+
+/*!
+ * Writes values up to and including the first one satisfying the predicate.
+ * Writes submitted after it complete as cancelled without reaching the
+ * stream, until reset() is called.
+ */
+template<WriteStreamable S, class P>
+using take_until_write_fn = detail::take_write_fn<S, P, true>;
+
+template<WriteStreamable S, class P>
+WriteStreamable take_until_write(S&& stream, P&& p)
+{
+    return take_until_write_fn<S, std::decay_t<P>>{std::forward<S>(stream),
+                                                   std::forward<P>(p)};
+}
+
+template<class P> class take_until_write_pipe
+{
+    P p_;
+
+  public:
+    take_until_write_pipe(P p) : p_(std::move(p)) {}
+
+    template<WriteStreamable S> WriteStreamable pipe(S&& s) const
+    {
+        return take_until_write_fn<S, P>{std::forward<S>(s), P(p_)};
+    }
+};
+
+template<class P> Pipeable take_until_write(P&& p)
+{
+    return take_until_write_pipe<std::decay_t<P>>{std::forward<P>(p)};
+}
 } // namespace stream
 
 #endif /* LIBSTREAM_TAKE_UNTIL_HPP_ */
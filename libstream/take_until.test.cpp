@@ -12,10 +12,16 @@
 #include <tests/helpers/submit_tester.hpp>
 #include <tests/mocks/readstream.hpp>
 #include <tests/mocks/readwritestream.hpp>
+#include <tests/mocks/writestream.hpp>
 
 #include <catch2/catch.hpp>
 #include <catch2/trompeloeil.hpp>
 
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 using namespace stream;
 using namespace std;
 using trompeloeil::_;
@@ -62,6 +68,233 @@ SCENARIO("Reads.")
     }
 }
 
+SCENARIO("Writes.")
+{
+    GIVEN("A stream that writes until 1.")
+    {
+        write_mock writer;
+        auto       s =
+            stream::take_until_write(writer, [](auto v) { return v == 1; });
+
+        WHEN("Single write is called.")
+        {
+            REQUIRE_CALL(writer, write(3)).LR_RETURN(writer.sender_);
+            auto sender = s.write(3);
+
+            test_sync_submit(writer.sender_, sender);
+            test_async_write_submit(writer.sender_, sender);
+            test_async_write_submit(writer.sender_, sender, dummy_error);
+        }
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(writer, write_(vector{3, 1}));
+            array a{3, 1, 2};
+            auto  sender = s.write(a);
+            REQUIRE(!s.stopped());
+
+            test_sync_submit(writer.range_sender_, sender);
+            REQUIRE(s.stopped());
+            test_async_range_submit(writer.range_sender_, sender);
+            test_async_range_submit(writer.range_sender_, sender, dummy_error);
+        }
+
+        WHEN("The terminating value is written.")
+        {
+            {
+                REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_);
+                REQUIRE_CALL(writer.sender_, submit());
+                s.write(1).submit();
+            }
+
+            THEN("Later writes complete as cancelled.")
+            {
+                REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+                auto sender = s.write(2);
+                FORBID_CALL(writer.sender_, submit());
+                sender.submit();
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+                REQUIRE_CALL(cancel_mock, call());
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+            }
+
+            THEN("Later range writes are not submitted.")
+            {
+                REQUIRE_CALL(writer, write_(vector{2, 3}));
+                array a{2, 3};
+                auto  sender = s.write(a);
+                FORBID_CALL(writer.range_sender_, submit());
+                sender.submit();
+            }
+
+            THEN("Writes reach the stream again after a reset.")
+            {
+                s.reset();
+                REQUIRE_CALL(writer, write_(vector{2, 3}));
+                REQUIRE_CALL(writer.range_sender_, submit());
+                array a{2, 3};
+                s.write(a).submit();
+            }
+        }
+
+        WHEN("A write is created before the terminating value is submitted.")
+        {
+            REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+            REQUIRE_CALL(writer, write(1)).LR_RETURN(writer.sender_);
+            auto later       = s.write(2);
+            auto terminating = s.write(1);
+            REQUIRE(!s.stopped());
+
+            THEN("It completes as cancelled if it is submitted afterwards.")
+            {
+                {
+                    REQUIRE_CALL(writer.sender_, submit());
+                    terminating.submit();
+                }
+                REQUIRE(s.stopped());
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+                FORBID_CALL(writer.sender_, submit(ANY(base_token)));
+                REQUIRE_CALL(cancel_mock, call());
+                later.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+            }
+        }
+    }
+}
+
+SCENARIO("Bulk terminator search.")
+{
+    GIVEN("A stream that reads until the terminator 1 in blocks of 4.")
+    {
+        read_mock reader;
+        auto s = stream::take_until_bulk_read(reader, terminator<int>{1}, 8);
+
+        WHEN("A range is read synchronously.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{3, 1, 2, 4});
+            REQUIRE_CALL(reader.range_sender_, submit());
+            array a{0, 0, 0};
+            auto  sender = s.read(a);
+            sender.submit();
+
+            THEN("It is read up to and including the terminator.")
+            {
+                REQUIRE_THAT(a, Equals(array{3, 1, 0}));
+                REQUIRE(sender.size() == 2);
+                REQUIRE(s.size() == 2);
+            }
+
+            AND_WHEN("The next range is read.")
+            {
+                REQUIRE_CALL(reader, read_(_))
+                    .SIDE_EFFECT(_1 = vector{5, 1, 6, 7});
+                REQUIRE_CALL(reader.range_sender_, submit());
+                array b{0, 0, 0, 0};
+                auto  next = s.read(b);
+                next.submit();
+
+                THEN("It starts with the values following the terminator.")
+                {
+                    REQUIRE_THAT(b, Equals(array{2, 4, 5, 1}));
+                    REQUIRE(next.size() == 4);
+                    REQUIRE(s.size() == 2);
+                }
+            }
+        }
+
+        WHEN("A range without the terminator is read.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{3, 4, 2, 5});
+            REQUIRE_CALL(reader.range_sender_, submit());
+            array a{0, 0, 0};
+            auto  sender = s.read(a);
+            sender.submit();
+
+            THEN("The whole range is read.")
+            {
+                REQUIRE_THAT(a, Equals(array{3, 4, 2}));
+                REQUIRE(sender.size() == 3);
+            }
+        }
+
+        WHEN("A range is read asynchronously.")
+        {
+            base_token t;
+            REQUIRE_CALL(reader, read_(_))
+                .TIMES(1, 2)
+                .SIDE_EFFECT(_1 = vector{3, 1, 2, 4});
+            REQUIRE_CALL(reader.range_sender_, submit(ANY(base_token)))
+                .TIMES(1, 2)
+                .LR_SIDE_EFFECT(t = _1);
+
+            done_callback_mock   callback_mock;
+            error_callback_mock  error_mock;
+            cancel_callback_mock cancel_mock;
+            array                a{0, 0, 0};
+            auto                 sender = s.read(a);
+            sender.submit(base_token{error_mock, cancel_mock, callback_mock});
+
+            THEN("The terminator is found once the block was read.")
+            {
+                REQUIRE_CALL(callback_mock, call());
+                t.done();
+                REQUIRE_THAT(a, Equals(array{3, 1, 0}));
+                REQUIRE(sender.size() == 2);
+            }
+
+            THEN("A failed read is reported.")
+            {
+                REQUIRE_CALL(error_mock, call(dummy_error));
+                t.error(dummy_error);
+            }
+        }
+    }
+
+    GIVEN("A terminator passed to take_until_read.")
+    {
+        read_mock reader;
+        auto      s = stream::take_until_read(reader, terminator<int>{1});
+
+        WHEN("A range is read.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{3, 1, 2});
+            array a{0, 0, 0};
+            s.read(a);
+
+            THEN("It stops at the terminator like any other predicate.")
+            {
+                REQUIRE_THAT(a, Equals(array{3, 1, 0}));
+            }
+        }
+    }
+
+    THEN("Terminators are found in and after whole blocks.")
+    {
+        for(size_t n = 0; n < 70; ++n)
+        {
+            for(size_t i = 0; i <= n; ++i)
+            {
+                vector<uint16_t> v(n, 7);
+                string           text(n, 'a');
+                if(i < n)
+                {
+                    v[i]    = 0;
+                    text[i] = '\n';
+                }
+                REQUIRE(terminator<uint16_t>{0}.find({v.data(), n}) == i);
+                REQUIRE(terminator<char>{'\n'}.find({text.data(), n}) == i);
+            }
+        }
+    }
+}
+
 SCENARIO("Cancelling operations.")
 {
     GIVEN("A stream that reads until 1.")
@@ -123,3 +356,9 @@ SCENARIO("Pipe operator")
     read_mock reader;
     reader | stream::take_until_read([](int v) { return v != 0; });
 }
+
+SCENARIO("Write pipe operator")
+{
+    write_mock writer;
+    writer | stream::take_until_write([](int v) { return v == 0; });
+}
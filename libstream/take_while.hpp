@@ -0,0 +1,114 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_TAKE_WHILE_HPP_
+#define LIBSTREAM_TAKE_WHILE_HPP_
+
+#include <liboutput_view/take_while.hpp>
+#include <libstream/concepts/pipe.hpp>
+#include <libstream/concepts/stream.hpp>
+#include <libstream/detail/context.hpp>
+#include <libstream/detail/take_write.hpp>
+
+#include <experimental/ranges/range>
+
+#include <type_traits>
+#include <utility>
+
+namespace stream
+{
+template<ReadStreamable S, class P> class take_while_read_fn
+{
+    S stream_;
+    P predicate_;
+
+  public:
+    take_while_read_fn(S&& stream, P p)
+        : stream_(std::forward<S>(stream)), predicate_(std::move(p))
+    {
+    }
+
+    template<std::experimental::ranges::Range R>
+    auto read(R&& r) const requires PureReadStreamable<S>
+    {
+        return detail::base_range_context{stream_.read(
+            output_view::take_while(std::forward<R>(r), predicate_))};
+    }
+
+    template<std::experimental::ranges::InputRange Rin,
+             std::experimental::ranges::Range      Rout>
+    auto readwrite(Rin&& rin, Rout& rout) const requires ReadWriteStreamable<S>
+    {
+        return detail::base_range_context{stream_.readwrite(
+            std::forward<Rin>(rin), output_view::take_while(rout, predicate_))};
+    }
+};
+
+template<ReadStreamable S, class P>
+take_while_read_fn(S&, P)->take_while_read_fn<S&, P>;
+template<ReadStreamable S, class P>
+take_while_read_fn(S&&, P)->take_while_read_fn<S, P>;
+
+template<ReadStreamable S, class P>
+ReadStreamable take_while_read(S&& stream, P&& p)
+{
+    return take_while_read_fn{std::forward<S>(stream), std::forward<P>(p)};
+}
+
+template<class P> class take_while_read_pipe
+{
+    P p_;
+
+  public:
+    take_while_read_pipe(P&& p) : p_(p) {}
+
+    template<ReadStreamable S> ReadStreamable pipe(S&& s) const
+    {
+        return take_while_read_fn<S, P>{std::forward<S>(s), P(p_)};
+    }
+};
+
+template<class P> Pipeable take_while_read(P&& p)
+{
+    return take_while_read_pipe{std::forward<P>(p)};
+}
+
+/*!
+ * Writes values as long as they satisfy the predicate. The first value which
+ * does not is dropped, it and writes submitted after it complete as cancelled
+ * without reaching the stream, until reset() is called.
+ */
+template<WriteStreamable S, class P>
+using take_while_write_fn = detail::take_write_fn<S, P, false>;
+
+template<WriteStreamable S, class P>
+WriteStreamable take_while_write(S&& stream, P&& p)
+{
+    return take_while_write_fn<S, std::decay_t<P>>{std::forward<S>(stream),
+                                                   std::forward<P>(p)};
+}
+
+template<class P> class take_while_write_pipe
+{
+    P p_;
+
+  public:
+    take_while_write_pipe(P p) : p_(std::move(p)) {}
+
+    template<WriteStreamable S> WriteStreamable pipe(S&& s) const
+    {
+        return take_while_write_fn<S, P>{std::forward<S>(s), P(p_)};
+    }
+};
+
+template<class P> Pipeable take_while_write(P&& p)
+{
+    return take_while_write_pipe<std::decay_t<P>>{std::forward<P>(p)};
+}
+} // namespace stream
+
+#endif /* LIBSTREAM_TAKE_WHILE_HPP_ */
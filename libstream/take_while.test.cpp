@@ -0,0 +1,152 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/take_while.hpp>
+
+#include <tests/helpers/constrained_types.hpp>
+#include <tests/helpers/range_matcher.hpp>
+#include <tests/helpers/submit_tester.hpp>
+#include <tests/mocks/readstream.hpp>
+#include <tests/mocks/readwritestream.hpp>
+#include <tests/mocks/writestream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <array>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+SCENARIO("Reads.")
+{
+    GIVEN("A stream that reads while the values are not 1.")
+    {
+        read_mock reader;
+        auto s = stream::take_while_read(reader, [](auto v) { return v != 1; });
+
+        WHEN("A range is read.")
+        {
+            REQUIRE_CALL(reader, read_(_)).SIDE_EFFECT(_1 = vector{3, 1, 2});
+            array a{0, 0, 0};
+            auto  sender = s.read(a);
+            REQUIRE_THAT(a, Equals(array{3, 0, 0}));
+
+            test_sync_submit(reader.range_sender_, sender);
+            test_async_range_submit(reader.range_sender_, sender);
+            test_async_range_submit(reader.range_sender_, sender, dummy_error);
+        }
+    }
+
+    GIVEN("A read-write stream that reads while the values are not 1.")
+    {
+        read_write_mock readwriter;
+        auto            s =
+            stream::take_while_read(readwriter, [](auto v) { return v != 1; });
+
+        WHEN("A range is read.")
+        {
+            REQUIRE_CALL(readwriter, readwrite_(vector{0, 1, 2}, _))
+                .SIDE_EFFECT(_2 = vector{3, 1, 2});
+            array a_read{0, 0, 0};
+            array a_write{0, 1, 2};
+            auto  sender = s.readwrite(a_write, a_read);
+            REQUIRE_THAT(a_read, Equals(array{3, 0, 0}));
+
+            test_sync_submit(readwriter.range_sender_, sender);
+            test_async_range_submit(readwriter.range_sender_, sender);
+            test_async_range_submit(readwriter.range_sender_, sender,
+                                    dummy_error);
+        }
+    }
+}
+
+SCENARIO("Writes.")
+{
+    GIVEN("A stream that writes while the values are not 1.")
+    {
+        write_mock writer;
+        auto       s =
+            stream::take_while_write(writer, [](auto v) { return v != 1; });
+
+        WHEN("Single write is called.")
+        {
+            REQUIRE_CALL(writer, write(3)).LR_RETURN(writer.sender_);
+            auto sender = s.write(3);
+
+            test_sync_submit(writer.sender_, sender);
+            test_async_write_submit(writer.sender_, sender);
+            test_async_write_submit(writer.sender_, sender, dummy_error);
+        }
+
+        WHEN("A range is written.")
+        {
+            REQUIRE_CALL(writer, write_(vector{3, 2}));
+            array a{3, 2, 1, 4};
+            auto  sender = s.write(a);
+            REQUIRE(!s.stopped());
+
+            test_sync_submit(writer.range_sender_, sender);
+            REQUIRE(s.stopped());
+            test_async_range_submit(writer.range_sender_, sender);
+            test_async_range_submit(writer.range_sender_, sender, dummy_error);
+        }
+
+        WHEN("A range is written which does not stop the stream.")
+        {
+            REQUIRE_CALL(writer, write_(vector{3, 2}));
+            array a{3, 2};
+            s.write(a);
+            REQUIRE(!s.stopped());
+        }
+
+        WHEN("The stopping value is written.")
+        {
+            auto sender = s.write(1);
+
+            THEN("It is dropped and completes as cancelled.")
+            {
+                FORBID_CALL(writer.sender_, submit());
+                sender.submit();
+
+                done_callback_mock   callback_mock;
+                error_callback_mock  error_mock;
+                cancel_callback_mock cancel_mock;
+                REQUIRE_CALL(cancel_mock, call());
+                sender.submit(
+                    base_token{error_mock, cancel_mock, callback_mock});
+            }
+
+            THEN("Writes reach the stream again after a reset.")
+            {
+                sender.submit();
+                REQUIRE(s.stopped());
+
+                s.reset();
+                REQUIRE_CALL(writer, write(2)).LR_RETURN(writer.sender_);
+                REQUIRE_CALL(writer.sender_, submit());
+                s.write(2).submit();
+            }
+        }
+    }
+}
+
+SCENARIO("R-value reader and callback")
+{
+    [[maybe_unused]] auto s = stream::take_while_read(
+        move_only_reader{}, [](int v) { return v != 0; });
+}
+
+SCENARIO("Pipe operator")
+{
+    read_mock  reader;
+    write_mock writer;
+    reader | stream::take_while_read([](int v) { return v != 0; });
+    writer | stream::take_while_write([](int v) { return v != 0; });
+}
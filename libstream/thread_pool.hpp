@@ -0,0 +1,263 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_THREAD_POOL_HPP_
+#define LIBSTREAM_THREAD_POOL_HPP_
+
+#include <libstream/work_item.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stream
+{
+namespace detail
+{
+/*!
+ * Bounded Chase-Lev deque. The owning thread pushes and pops at the bottom,
+ * other threads steal from the top.
+ */
+template<std::size_t Capacity> class work_stealing_deque
+{
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "The capacity has to be a power of two.");
+    static constexpr std::int64_t mask = Capacity - 1;
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::array<std::atomic<work_item*>, Capacity> buffer_{};
+
+  public:
+    /*!
+     * Returns false if the deque is full.
+     */
+    bool push(work_item* w)
+    {
+        auto b = bottom_.load(std::memory_order_relaxed);
+        auto t = top_.load(std::memory_order_acquire);
+        if(b - t >= static_cast<std::int64_t>(Capacity)) { return false; }
+        buffer_[b & mask].store(w, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    work_item* pop()
+    {
+        auto b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top_.load(std::memory_order_relaxed);
+        if(t > b)
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        work_item* w = buffer_[b & mask].load(std::memory_order_relaxed);
+        if(t == b)
+        {
+            if(!top_.compare_exchange_strong(t, t + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed))
+            {
+                w = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return w;
+    }
+
+    /*!
+     * Returns nullptr if the deque is empty or another thread won the race
+     * for the top item.
+     */
+    work_item* steal()
+    {
+        auto t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom_.load(std::memory_order_acquire);
+        if(t >= b) { return nullptr; }
+
+        work_item* w = buffer_[t & mask].load(std::memory_order_relaxed);
+        if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        return w;
+    }
+};
+} // namespace detail
+
+/*!
+ * Work-stealing executor.
+ *
+ * Work items posted by a worker of the pool go to the deque of that worker,
+ * so a continuation usually stays on the thread and the cache which produced
+ * its input. Idle workers steal from the other deques. Work items posted from
+ * other threads, and by a worker whose deque is full, go to a shared queue.
+ * Work items still queued when the pool is destroyed are executed before the
+ * workers exit.
+ */
+class thread_pool
+{
+    static constexpr std::size_t deque_capacity = 1024;
+
+    struct worker
+    {
+        detail::work_stealing_deque<deque_capacity> deque_;
+        std::thread                                 thread_;
+    };
+
+    std::vector<std::unique_ptr<worker>> workers_;
+
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    work_item*              shared_head_ = nullptr;
+    work_item*              shared_tail_ = nullptr;
+
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<bool>        stop_{false};
+
+    static worker*& current_worker()
+    {
+        static thread_local worker* current = nullptr;
+        return current;
+    }
+
+    static thread_pool*& current_pool()
+    {
+        static thread_local thread_pool* current = nullptr;
+        return current;
+    }
+
+    void wake_one()
+    {
+        if(sleepers_.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+            }
+            wake_.notify_one();
+        }
+    }
+
+    work_item* pop_shared()
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        work_item*                  w = shared_head_;
+        if(w != nullptr)
+        {
+            shared_head_ = w->next_;
+            if(shared_head_ == nullptr) { shared_tail_ = nullptr; }
+            w->next_ = nullptr;
+        }
+        return w;
+    }
+
+    work_item* find_work(std::size_t self)
+    {
+        if(auto* w = workers_[self]->deque_.pop()) { return w; }
+        if(auto* w = pop_shared()) { return w; }
+        for(std::size_t i = 1; i < workers_.size(); ++i)
+        {
+            auto victim = (self + i) % workers_.size();
+            if(auto* w = workers_[victim]->deque_.steal()) { return w; }
+        }
+        return nullptr;
+    }
+
+    void run(std::size_t self)
+    {
+        current_worker() = workers_[self].get();
+        current_pool()   = this;
+
+        while(true)
+        {
+            if(auto* w = find_work(self))
+            {
+                pending_.fetch_sub(1);
+                w->execute();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{mutex_};
+            sleepers_.fetch_add(1);
+            wake_.wait(lock, [this] {
+                return pending_.load() > 0 || stop_.load();
+            });
+            sleepers_.fetch_sub(1);
+            if(pending_.load() == 0 && stop_.load()) { return; }
+        }
+    }
+
+  public:
+    explicit thread_pool(
+        std::size_t threads = std::thread::hardware_concurrency())
+    {
+        if(threads == 0) { threads = 1; }
+        workers_.reserve(threads);
+        for(std::size_t i = 0; i < threads; ++i)
+        {
+            workers_.push_back(std::make_unique<worker>());
+        }
+        for(std::size_t i = 0; i < threads; ++i)
+        {
+            workers_[i]->thread_ = std::thread{[this, i] { run(i); }};
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_.store(true);
+        }
+        wake_.notify_all();
+        for(auto& w : workers_) { w->thread_.join(); }
+    }
+
+    void post(work_item& w)
+    {
+        pending_.fetch_add(1);
+        if(current_pool() == this && current_worker()->deque_.push(&w))
+        {
+            wake_one();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            w.next_ = nullptr;
+            if(shared_tail_ == nullptr) { shared_head_ = &w; }
+            else
+            {
+                shared_tail_->next_ = &w;
+            }
+            shared_tail_ = &w;
+        }
+        wake_one();
+    }
+
+    std::size_t size() const noexcept { return workers_.size(); }
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_THREAD_POOL_HPP_
@@ -0,0 +1,123 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#include <libstream/thread_pool.hpp>
+
+#include <libstream/on.hpp>
+#include <libstream/transform.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace stream;
+using namespace std;
+
+namespace
+{
+atomic<int> executed{0};
+
+struct counting_item : work_item
+{
+    thread_pool*   pool_  = nullptr;
+    counting_item* child_ = nullptr;
+
+    counting_item()
+        : work_item([](work_item* w) {
+              auto* self = static_cast<counting_item*>(w);
+              ++executed;
+              if(self->child_ != nullptr) { self->pool_->post(*self->child_); }
+          })
+    {
+    }
+};
+
+struct inline_reader
+{
+    struct sender
+    {
+        int  submit() { return 1; }
+        void submit(read_token<int>&& t) { t.done(1); }
+        void cancel() {}
+    };
+
+    sender read() const { return sender{}; }
+};
+
+struct promise_callback
+{
+    promise<pair<int, thread::id>>& result_;
+
+    void operator()(int v) { result_.set_value({v, this_thread::get_id()}); }
+};
+
+struct ignore_error
+{
+    void operator()(error_code) {}
+};
+
+struct ignore_cancel
+{
+    void operator()() {}
+};
+} // namespace
+
+SCENARIO("Posting to a thread pool.")
+{
+    GIVEN("Work items which post another work item.")
+    {
+        executed = 0;
+        vector<counting_item> items(10000), children(10000);
+
+        WHEN("They are posted to a pool and the pool is destroyed.")
+        {
+            {
+                thread_pool pool{4};
+                REQUIRE(pool.size() == 4);
+                for(size_t i = 0; i < items.size(); ++i)
+                {
+                    items[i].pool_  = &pool;
+                    items[i].child_ = &children[i];
+                }
+                for(auto& i : items) { pool.post(i); }
+            }
+
+            THEN("All of them are executed.") { REQUIRE(executed == 20000); }
+        }
+    }
+}
+
+SCENARIO("Transforming on a thread pool.")
+{
+    GIVEN("A read stream whose transform runs on a pool.")
+    {
+        thread_pool   pool{2};
+        inline_reader reader;
+        auto s = reader | on(pool) | transform_read([](int v) { return v * 3; });
+
+        WHEN("A value is read asynchronously.")
+        {
+            promise<pair<int, thread::id>> result;
+            promise_callback               callback{result};
+            ignore_error                   error;
+            ignore_cancel                  cancel;
+
+            auto sender = s.read();
+            sender.submit(read_token<int>{error, cancel, callback});
+            auto r = result.get_future().get();
+
+            THEN("The transformed value is delivered by a worker.")
+            {
+                REQUIRE(r.first == 3);
+                REQUIRE(r.second != this_thread::get_id());
+            }
+        }
+    }
+}
@@ -0,0 +1,289 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_TRACE_HPP_
+#define LIBSTREAM_TRACE_HPP_
+
+/*!
+ * Opt-in tracing of the contexts in detail/ and action.hpp.
+ *
+ * If LIBSTREAM_TRACE is defined, every asynchronous submission records a
+ * begin event and its completion records an end event, synchronous
+ * submissions record both around the call. Events are stored in a ring of
+ * LIBSTREAM_TRACE_CAPACITY events per thread and dumped as Chrome trace JSON
+ * by write_chrome_trace(). Without LIBSTREAM_TRACE the hooks expand to
+ * nothing, so contexts neither grow nor execute additional code, and
+ * write_chrome_trace() is left out together with <ostream>. The macro has to
+ * be defined for all translation units of a program.
+ */
+
+#include <libstream/callback.hpp>
+
+#ifdef LIBSTREAM_TRACE
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <utility>
+#endif
+
+#ifndef LIBSTREAM_TRACE_CAPACITY
+#define LIBSTREAM_TRACE_CAPACITY 4096
+#endif
+
+namespace stream
+{
+#ifdef LIBSTREAM_TRACE
+namespace detail
+{
+enum class trace_phase : std::uint8_t
+{
+    submit,
+    done,
+    error,
+    cancelled,
+    sync_begin,
+    sync_end
+};
+
+struct trace_event
+{
+    std::atomic<std::uint64_t> time_{0};
+    std::atomic<const char*>   name_{nullptr};
+    std::atomic<const void*>   id_{nullptr};
+    std::atomic<trace_phase>   phase_{trace_phase::submit};
+};
+
+/*!
+ * Events of a single thread. Only the owning thread records, so recording is
+ * wait-free. Once the ring is full the oldest events are overwritten, a
+ * concurrent reader discards the events which may have been overwritten
+ * while it copied them.
+ */
+class trace_ring
+{
+    static constexpr std::size_t capacity = LIBSTREAM_TRACE_CAPACITY;
+
+    std::array<trace_event, capacity> events_;
+    std::atomic<std::uint64_t>        head_{0};
+
+  public:
+    const unsigned thread_;
+    trace_ring*    next_ = nullptr;
+
+    explicit trace_ring(unsigned thread) : thread_(thread) {}
+
+    void record(trace_phase phase, const char* name, const void* id) noexcept
+    {
+        using namespace std::chrono;
+        auto time = duration_cast<nanoseconds>(
+                        steady_clock::now().time_since_epoch())
+                        .count();
+
+        auto  head  = head_.load(std::memory_order_relaxed);
+        auto& event = events_[head % capacity];
+        std::atomic_thread_fence(std::memory_order_release);
+        event.time_.store(static_cast<std::uint64_t>(time),
+                          std::memory_order_relaxed);
+        event.name_.store(name, std::memory_order_relaxed);
+        event.id_.store(id, std::memory_order_relaxed);
+        event.phase_.store(phase, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template<class F> void for_each(F&& f) const
+    {
+        auto head  = head_.load(std::memory_order_acquire);
+        auto first = head > capacity ? head - capacity : 0;
+
+        for(auto i = first; i != head; ++i)
+        {
+            auto& event = events_[i % capacity];
+            auto  time  = event.time_.load(std::memory_order_relaxed);
+            auto  name  = event.name_.load(std::memory_order_relaxed);
+            auto  id    = event.id_.load(std::memory_order_relaxed);
+            auto  phase = event.phase_.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(i + capacity <= head_.load(std::memory_order_relaxed))
+            {
+                continue;
+            }
+            f(time, name, id, phase);
+        }
+    }
+};
+
+struct trace_registry
+{
+    std::atomic<trace_ring*> rings_{nullptr};
+    std::atomic<unsigned>    threads_{0};
+};
+
+inline trace_registry& trace_rings()
+{
+    static trace_registry registry;
+    return registry;
+}
+
+/*!
+ * Ring of the calling thread. Rings are never freed, so the events of
+ * threads which have already exited can still be dumped.
+ */
+inline trace_ring& this_thread_trace()
+{
+    thread_local trace_ring* ring = [] {
+        auto& registry = trace_rings();
+        auto* r        = new trace_ring{registry.threads_.fetch_add(1) + 1};
+        r->next_       = registry.rings_.load(std::memory_order_relaxed);
+        while(!registry.rings_.compare_exchange_weak(
+            r->next_, r, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        return r;
+    }();
+    return *ring;
+}
+
+inline void trace(trace_phase phase, const char* name, const void* id) noexcept
+{
+    this_thread_trace().record(phase, name, id);
+}
+
+/*!
+ * Token handed to the child of a traced context. It records the completion
+ * and forwards it to the token of the context.
+ */
+template<class Token> class trace_token;
+
+template<class... Ret> class trace_token<token<Ret...>>
+{
+    using this_t     = trace_token<token<Ret...>>;
+    using token_type = token<Ret...>;
+
+    token_type  token_;
+    const char* name_ = nullptr;
+
+    void error_handler(error_code e)
+    {
+        trace(trace_phase::error, name_, this);
+        token_.error(e);
+    }
+
+    void cancel_handler()
+    {
+        trace(trace_phase::cancelled, name_, this);
+        token_.cancelled();
+    }
+
+    void done_handler(Ret... v)
+    {
+        trace(trace_phase::done, name_, this);
+        token_.done(std::move(v)...);
+    }
+
+  public:
+    token_type wrap(const char* name, token_type&& t)
+    {
+        token_ = std::move(t);
+        name_  = name;
+        trace(trace_phase::submit, name_, this);
+        return {
+            error_token::template create<this_t, &this_t::error_handler>(this),
+            cancel_token::template create<this_t, &this_t::cancel_handler>(
+                this),
+            decltype(token_.done)::template create<this_t,
+                                                   &this_t::done_handler>(
+                this)};
+    }
+};
+
+/*!
+ * Records a synchronous submission for the lifetime of the scope.
+ */
+class trace_scope
+{
+    const char* name_;
+    const void* id_;
+
+  public:
+    trace_scope(const char* name, const void* id) : name_(name), id_(id)
+    {
+        trace(trace_phase::sync_begin, name_, id_);
+    }
+
+    ~trace_scope() { trace(trace_phase::sync_end, name_, id_); }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+};
+
+inline void write_trace_event(std::ostream& os, unsigned thread,
+                              std::uint64_t time, const char* name,
+                              const void* id, trace_phase phase)
+{
+    static constexpr const char* phases[]  = {"b", "e", "e", "e", "B", "E"};
+    static constexpr const char* results[] = {
+        "", "done", "error", "cancelled", "", ""};
+
+    auto p = static_cast<std::size_t>(phase);
+    os << "{\"name\":\"" << name << "\",\"cat\":\"stream\",\"ph\":\""
+       << phases[p] << "\",\"ts\":" << time / 1000 << '.' << std::setw(3)
+       << std::setfill('0') << time % 1000 << std::setfill(' ')
+       << ",\"pid\":0,\"tid\":" << thread;
+    if(phase < trace_phase::sync_begin)
+    {
+        os << ",\"id\":\"" << id << '"';
+    }
+    if(*results[p] != '\0')
+    {
+        os << ",\"args\":{\"result\":\"" << results[p] << "\"}";
+    }
+    os << '}';
+}
+} // namespace detail
+
+#define LIBSTREAM_TRACE_TOKEN(Token)                                           \
+    ::stream::detail::trace_token<Token> trace_token_{};
+#define LIBSTREAM_TRACE_WRAP(name, t) this->trace_token_.wrap(name, t)
+#define LIBSTREAM_TRACE_SYNC(name)                                             \
+    ::stream::detail::trace_scope trace_scope_{name, this};
+
+/*!
+ * Writes the recorded events of all threads as Chrome trace JSON, which can
+ * be loaded by chrome://tracing or Perfetto. Asynchronous operations are
+ * async events identified by their context, synchronous submissions are
+ * duration events on their thread.
+ */
+inline void write_chrome_trace(std::ostream& os)
+{
+    bool first = true;
+    os << "{\"traceEvents\":[";
+    for(auto* ring = detail::trace_rings().rings_.load(
+            std::memory_order_acquire);
+        ring != nullptr; ring = ring->next_)
+    {
+        ring->for_each([&](auto time, auto name, auto id, auto phase) {
+            if(!first) { os << ','; }
+            first = false;
+            detail::write_trace_event(os, ring->thread_, time, name, id,
+                                      phase);
+        });
+    }
+    os << "]}";
+}
+#else
+#define LIBSTREAM_TRACE_TOKEN(Token)
+#define LIBSTREAM_TRACE_WRAP(name, t) t
+#define LIBSTREAM_TRACE_SYNC(name)
+#endif
+} // namespace stream
+
+#endif // LIBSTREAM_TRACE_HPP_
@@ -0,0 +1,186 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#define LIBSTREAM_TRACE_CAPACITY 64
+
+#include <libstream/trace.hpp>
+
+#include <libstream/measure.hpp>
+#include <libstream/multiplex.hpp>
+#include <libstream/transform.hpp>
+
+#include <tests/mocks/callback.hpp>
+#include <tests/mocks/readstream.hpp>
+
+#include <catch2/catch.hpp>
+#include <catch2/trompeloeil.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace stream;
+using namespace std;
+using trompeloeil::_;
+
+namespace
+{
+std::size_t count_events(const std::string& pattern)
+{
+    std::ostringstream os;
+    write_chrome_trace(os);
+
+    auto        trace = os.str();
+    std::size_t n     = 0;
+    for(auto i = trace.find(pattern); i != std::string::npos;
+        i      = trace.find(pattern, i + 1))
+    {
+        ++n;
+    }
+    return n;
+}
+
+const std::string begin_event =
+    R"({"name":"transform_read","cat":"stream","ph":"b")";
+const std::string sync_begin_event =
+    R"({"name":"transform_read","cat":"stream","ph":"B")";
+const std::string sync_end_event =
+    R"({"name":"transform_read","cat":"stream","ph":"E")";
+const std::string measure_begin_event =
+    R"({"name":"measure","cat":"stream","ph":"b")";
+const std::string multiplex_begin_event =
+    R"({"name":"multiplex_read","cat":"stream","ph":"b")";
+} // namespace
+
+SCENARIO("Tracing of contexts.")
+{
+    GIVEN("A traced read stream that doubles.")
+    {
+        read_mock reader;
+        auto s = stream::transform_read(reader, [](auto v) { return v * 2; });
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_callback_mock   value_mock;
+
+        REQUIRE_CALL(reader, read()).LR_RETURN(reader.sender_);
+        auto sender = s.read();
+
+        WHEN("A read is submitted asynchronously.")
+        {
+            read_token<int> t;
+            REQUIRE_CALL(reader.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+
+            auto begins = count_events(begin_event);
+            auto dones  = count_events(R"("result":"done")");
+            auto errors = count_events(R"("result":"error")");
+            sender.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+
+            THEN("The submission is recorded.")
+            {
+                REQUIRE(count_events(begin_event) == begins + 1);
+            }
+
+            THEN("The completion is recorded before the token is invoked.")
+            {
+                std::size_t recorded = 0;
+                REQUIRE_CALL(value_mock, call(2))
+                    .LR_SIDE_EFFECT(
+                        recorded = count_events(R"("result":"done")"));
+                t.done(1);
+                REQUIRE(recorded == dones + 1);
+            }
+
+            THEN("Errors are recorded.")
+            {
+                REQUIRE_CALL(error_mock, call(dummy_error));
+                t.error(dummy_error);
+                REQUIRE(count_events(R"("result":"error")") == errors + 1);
+            }
+        }
+
+        WHEN("A read is submitted synchronously.")
+        {
+            REQUIRE_CALL(reader.sender_, submit()).RETURN(1);
+
+            auto begins = count_events(sync_begin_event);
+            auto ends   = count_events(sync_end_event);
+            REQUIRE(sender.submit() == 2);
+
+            THEN("The call is recorded as duration.")
+            {
+                REQUIRE(count_events(sync_begin_event) == begins + 1);
+                REQUIRE(count_events(sync_end_event) == ends + 1);
+            }
+        }
+
+        WHEN("A read is submitted on another thread.")
+        {
+            REQUIRE_CALL(reader.sender_, submit()).RETURN(1);
+
+            auto begins = count_events(sync_begin_event);
+            std::thread([&] { sender.submit(); }).join();
+
+            THEN("Its events are dumped after the thread exited.")
+            {
+                REQUIRE(count_events(sync_begin_event) == begins + 1);
+            }
+        }
+
+        WHEN("More events are recorded than fit into the ring.")
+        {
+            REQUIRE_CALL(reader.sender_, submit()).TIMES(100).RETURN(1);
+            for(int i = 0; i < 100; ++i) { sender.submit(); }
+
+            THEN("Only the newest events are kept.")
+            {
+                REQUIRE(count_events(R"("ph":")") <= 2 * 64);
+                REQUIRE(count_events(sync_end_event) >= 32);
+            }
+        }
+    }
+
+    GIVEN("A traced measured stream which multiplexes two sources.")
+    {
+        read_mock first;
+        read_mock second;
+        histogram latency;
+        auto      s = stream::measure(
+            stream::multiplex_read(round_robin, first, second), latency);
+
+        error_callback_mock  error_mock;
+        cancel_callback_mock cancel_mock;
+        read_callback_mock   value_mock;
+
+        REQUIRE_CALL(first, read()).LR_RETURN(first.sender_);
+        REQUIRE_CALL(second, read()).LR_RETURN(second.sender_);
+        auto sender = s.read();
+
+        WHEN("A read is submitted asynchronously.")
+        {
+            read_token<int> t;
+            REQUIRE_CALL(first.sender_, submit(ANY(read_token<int>)))
+                .LR_SIDE_EFFECT(t = _1);
+
+            auto measures    = count_events(measure_begin_event);
+            auto multiplexes = count_events(multiplex_begin_event);
+            sender.submit(read_token<int>{error_mock, cancel_mock, value_mock});
+
+            THEN("Both stages are recorded.")
+            {
+                REQUIRE(count_events(measure_begin_event) == measures + 1);
+                REQUIRE(count_events(multiplex_begin_event) ==
+                        multiplexes + 1);
+
+                REQUIRE_CALL(value_mock, call(1));
+                t.done(1);
+            }
+        }
+    }
+}
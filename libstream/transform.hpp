@@ -11,7 +11,11 @@
 #include <liboutput_view/transform.hpp>
 #include <libstream/callback.hpp>
 #include <libstream/concepts/pipe.hpp>
+#include <libstream/connect.hpp>
 #include <libstream/detail/context.hpp>
+#include <libstream/fused.hpp>
+#include <libstream/kernel.hpp>
+#include <libstream/span.hpp>
 
 #include <experimental/ranges/range>
 
@@ -19,6 +23,38 @@ namespace stream
 {
 namespace detail
 {
+/*!
+ * A read_context connected to a receiver. The child completes to this
+ * operation with a direct call.
+ */
+template<class C, class S, class R> class read_operation
+{
+    using value_type = decltype(std::declval<C&>().submit());
+
+    struct receiver
+    {
+        read_operation* op_;
+
+        void done(value_type v) { op_->receiver_.done(op_->stream_.func_(v)); }
+        void error(error_code e) { op_->receiver_.error(e); }
+        void cancelled() { op_->receiver_.cancelled(); }
+    };
+
+    S&                            stream_;
+    R                             receiver_;
+    connect_result_t<C, receiver> child_;
+
+  public:
+    read_operation(C&& c, S& s, R&& r)
+        : stream_(s), receiver_(std::forward<R>(r)),
+          child_(stream::connect(std::forward<C>(c), receiver{this}))
+    {
+    }
+
+    void start() { child_.start(); }
+    void cancel() { child_.cancel(); }
+};
+
 template<class C, class S> class read_context : public base_read_context<C>
 {
     using typename base_read_context<C>::value_type;
@@ -35,20 +71,81 @@ template<class C, class S> class read_context : public base_read_context<C>
     {
     }
 
-    auto submit() { return stream_.func_(child_.submit()); }
+    auto submit()
+    {
+        LIBSTREAM_TRACE_SYNC("transform_read")
+        return stream_.func_(child_.submit());
+    }
 
     void submit(read_token<value_type>&& t)
     {
-        done_token_  = t.done;
+        read_token<value_type> traced =
+            LIBSTREAM_TRACE_WRAP("transform_read", std::move(t));
+        done_token_  = traced.done;
         using this_t = read_context<C, S>;
-        child_.submit(
-            read_token<value_type>{t.error, t.cancelled,
-                                   read_done_token<value_type>::template create<
-                                       this_t, &this_t::done_handler>(this)});
+        child_.submit(read_token<value_type>{
+            traced.error, traced.cancelled,
+            read_done_token<value_type>::template create<
+                this_t, &this_t::done_handler>(this)});
+    }
+
+    using base_read_context<C>::cancel;
+
+    template<class R> auto connect(R&& r) &&
+    {
+        return read_operation<C, S, R>{std::forward<C>(child_), stream_,
+                                       std::forward<R>(r)};
     }
 };
 
 template<class C, class S> read_context(C&& c, S& s)->read_context<C, S>;
+
+/*!
+ * Reads into a contiguous range and applies a bulk kernel to the whole range
+ * once the child completed.
+ */
+template<class C, class T, class K> class bulk_read_context
+{
+    using this_t = bulk_read_context<C, T, K>;
+
+    C          child_;
+    span<T>    range_;
+    const K&   kernel_;
+    base_token token_;
+    LIBSTREAM_TRACE_TOKEN(base_token)
+
+    void done_handler()
+    {
+        kernel_(range_);
+        token_.done();
+    }
+
+  public:
+    bulk_read_context(C&& c, span<T> r, const K& k)
+        : child_(std::forward<C>(c)), range_(r), kernel_(k)
+    {
+    }
+
+    void submit()
+    {
+        LIBSTREAM_TRACE_SYNC("transform_read_bulk")
+        child_.submit();
+        kernel_(range_);
+    }
+
+    void submit(base_token&& t)
+    {
+        token_ = LIBSTREAM_TRACE_WRAP("transform_read_bulk", std::move(t));
+        child_.submit(base_token{
+            token_.error, token_.cancelled,
+            done_token::template create<this_t, &this_t::done_handler>(this)});
+    }
+
+    void cancel() { child_.cancel(); }
+};
+
+template<class C, class T, class K>
+bulk_read_context(C&& c, span<T> r, const K& k)->bulk_read_context<C, T, K>;
 } // namespace detail
 
 template<WriteStreamable S, class F> class transform_write_fn
@@ -116,6 +213,18 @@ template<ReadStreamable S, class F> class transform_read_fn
             stream_.read(output_view::transform(r, func_))};
     }
 
+    template<std::experimental::ranges::ContiguousRange R>
+    auto read(R&& r) const requires PureReadStreamable<S> &&
+        BulkKernel<F, detail::contiguous_value_t<R>>
+    {
+        namespace ranges = std::experimental::ranges;
+        return detail::bulk_read_context{
+            stream_.read(r),
+            span<detail::contiguous_value_t<R>>{ranges::data(r),
+                                                ranges::size(r)},
+            func_};
+    }
+
     template<class V>
     auto readwrite(V&& v) const requires ReadWriteStreamable<S>
     {
@@ -165,6 +274,8 @@ template<class F> class transform_read_pipe
     {
         return transform_read_fn<S, F>{std::forward<S>(s), F(f_)};
     }
+
+    auto read_ops() const { return std::tuple{detail::transform_op<F>{f_}}; }
 };
 
 template<class F> Pipeable transform_write(F&& f)
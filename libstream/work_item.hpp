@@ -0,0 +1,44 @@
+/*!
+ * @author    Patrick Wang-Freninger <github@freninger.at>
+ * @copyright MIT
+ * @date      2019
+ * @link      github.com/PVIII/stream
+ */
+
+#ifndef LIBSTREAM_WORK_ITEM_HPP_
+#define LIBSTREAM_WORK_ITEM_HPP_
+
+#include <cstdint>
+
+namespace stream
+{
+/*!
+ * Intrusive node of the queues of an executor.
+ *
+ * The owner of a work item keeps it alive until it was executed. A work item
+ * must not be posted again before it was executed.
+ */
+struct work_item
+{
+    void (*execute_)(work_item*) = nullptr;
+    work_item* next_             = nullptr;
+
+    constexpr work_item() = default;
+    constexpr explicit work_item(void (*f)(work_item*)) : execute_(f) {}
+
+    void execute() { execute_(this); }
+};
+
+/*!
+ * Work item which is executed once its deadline has passed.
+ */
+struct timer_item : work_item
+{
+    std::uint64_t deadline_ = 0;
+
+    using work_item::work_item;
+};
+
+} // namespace stream
+
+#endif // LIBSTREAM_WORK_ITEM_HPP_